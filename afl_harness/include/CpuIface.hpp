@@ -10,9 +10,24 @@
 
 #pragma once
 
+#include "MemDigest.hpp"
+#include "Trace.hpp"
 #include <vector>
+#include <cstddef>
 #include <cstdint>
 
+/**
+ * @enum CommitStatus
+ * @brief Why CpuIface::run_until_commit() returned
+ */
+enum class CommitStatus {
+  Commit,      ///< An instruction retired; the CommitRec is filled in
+  Finish,      ///< The DUT raised its finish condition ($finish)
+  Trap,        ///< trap() went high on a cycle with no retired instruction
+  DeviceExit,  ///< A bus device (tohost) requested termination
+  Budget       ///< max_cycles elapsed without any of the above
+};
+
 /**
  * @class CpuIface
  * @brief Abstract interface for CPU/DUT (Device Under Test) implementations
@@ -29,6 +44,9 @@
  * against a golden model (Spike).
  * 
  * @note All RVFI methods follow the RISC-V Formal standard specification
+ * @note Instances must not share mutable state: make_cpu() returns a new,
+ *       independent DUT on each call, and distinct instances may be driven
+ *       from different threads concurrently (one thread per instance)
  * @see https://github.com/riscv/riscv-formal
  * 
  * Example usage:
@@ -64,7 +82,39 @@ public:
    *       initial register values) should match the target hardware
    */
   virtual void reset() = 0;
-  
+
+  /**
+   * @brief Snapshot the current simulator state (optional)
+   *
+   * Intended to be called once, right after the first reset(), so that
+   * later inputs can return to the post-reset state with restore_state()
+   * instead of clocking the reset sequence again.
+   *
+   * @return true if a snapshot was taken (default: false = unsupported)
+   */
+  virtual bool save_state() { return false; }
+
+  /**
+   * @brief Return to the state captured by save_state() (optional)
+   *
+   * Equivalent to reset() when the snapshot was taken right after reset:
+   * architectural and pipeline state, memory contents and any pending
+   * finish condition are all restored.
+   *
+   * @return true on success; false if no snapshot exists, in which case
+   *         the caller should fall back to reset()
+   *
+   * Example:
+   * @code
+   *   if (!cpu->restore_state()) {
+   *     cpu->reset();
+   *     cpu->save_state();
+   *   }
+   *   cpu->load_input(input);
+   * @endcode
+   */
+  virtual bool restore_state() { return false; }
+
   /**
    * @brief Load fuzzer-generated input into CPU memory
    * 
@@ -72,7 +122,11 @@ public:
    * memory space at the configured base address. The input typically
    * consists of raw RISC-V machine code instructions.
    * 
-   * @param in Vector of bytes containing the instruction stream to execute
+   * Takes a raw pointer so callers can pass AFL++'s shared-memory testcase
+   * buffer directly; the bytes are copied into DUT memory exactly once.
+   * 
+   * @param data Pointer to the instruction stream to execute
+   * @param len Number of bytes at @p data
    * 
    * @note The memory layout (base address, size limits) is typically
    *       configured through environment variables (RAM_BASE, RAM_SIZE)
@@ -80,11 +134,23 @@ public:
    * 
    * Example:
    * @code
+   *   cpu->load_input(__AFL_FUZZ_TESTCASE_BUF, __AFL_FUZZ_TESTCASE_LEN);
+   * @endcode
+   */
+  virtual void load_input(const unsigned char* data, size_t len) = 0;
+
+  /**
+   * @brief Convenience overload for inputs already held in a vector
+   * 
+   * @param in Vector of bytes containing the instruction stream to execute
+   * 
+   * Example:
+   * @code
    *   std::vector<unsigned char> input = {0x13, 0x00, 0x00, 0x00}; // nop
    *   cpu->load_input(input);
    * @endcode
    */
-  virtual void load_input(const std::vector<unsigned char>& in) = 0;
+  void load_input(const std::vector<unsigned char>& in) { load_input(in.data(), in.size()); }
   
   /**
    * @brief Execute one clock cycle of the CPU
@@ -126,6 +192,97 @@ public:
    */
   virtual bool trap() const = 0;
 
+  /**
+   * @brief Whether tohost stores are detected on the DUT bus (optional)
+   * 
+   * When true, run_until_commit() returns CommitStatus::DeviceExit as soon
+   * as the program stores to the tohost address, and the harness skips its
+   * per-commit tohost address comparison.
+   * 
+   * @return true if the bus model signals tohost exits (default: false)
+   */
+  virtual bool handles_tohost() const { return false; }
+
+  /**
+   * @brief Record every data write on the DUT bus in write_digest() (optional)
+   * 
+   * Off by default. Once on, the digest is cleared by reset() and
+   * restore_state() and sees every store the DUT puts on its bus, including
+   * stores that never retire or that RVFI does not report.
+   * 
+   * @param on Enable or disable tracking
+   */
+  virtual void track_writes(bool on) { (void)on; }
+
+  /**
+   * @brief Memory written by the DUT since the last reset (optional)
+   * 
+   * @return The digest, or nullptr if the model does not track writes or
+   *         track_writes() is off (default: nullptr)
+   * @see MemDigest
+   */
+  virtual const MemDigest* write_digest() const { return nullptr; }
+
+  /**
+   * @brief Step until the next retired instruction and capture it
+   * 
+   * Runs up to @p max_cycles clock cycles and stops after the first cycle
+   * on which the DUT finishes, retires an instruction, or traps without
+   * retiring one. On CommitStatus::Commit every field of @p rec that the
+   * RVFI accessors below can provide (including the CSR updates) is filled
+   * in, so the caller needs no further per-commit virtual calls.
+   * 
+   * The default implementation is built on step() and the RVFI accessors;
+   * simulator backends should override it to read their signals directly.
+   * 
+   * @param rec Output commit record (valid for Commit; trap set for Trap)
+   * @param max_cycles Maximum number of cycles to run (0 returns Budget)
+   * @param cycles Output: number of cycles actually stepped
+   * @return Reason for returning
+   * 
+   * Example:
+   * @code
+   *   CommitRec rec;
+   *   unsigned n = 0;
+   *   while (cpu->run_until_commit(rec, budget, n) == CommitStatus::Commit) {
+   *     budget -= n;
+   *     trace.write(rec);
+   *   }
+   * @endcode
+   */
+  virtual CommitStatus run_until_commit(CommitRec& rec, unsigned max_cycles, unsigned& cycles) {
+    for (cycles = 0; cycles < max_cycles;) {
+      step();
+      ++cycles;
+      if (got_finish()) return CommitStatus::Finish;
+      if (rvfi_valid()) {
+        rec.pc_r      = rvfi_pc_rdata();
+        rec.pc_w      = rvfi_pc_wdata();
+        rec.insn      = rvfi_insn();
+        rec.rd_addr   = rvfi_rd_addr();
+        rec.rd_wdata  = rvfi_rd_wdata();
+        rec.mem_addr  = rvfi_mem_addr();
+        rec.mem_rmask = rvfi_mem_rmask();
+        rec.mem_wmask = rvfi_mem_wmask();
+        rec.mem_wdata = rvfi_mem_wdata();
+        rec.mem_rdata = rvfi_mem_rdata();
+        rec.trap      = trap() ? 1u : 0u;
+        rec.csr_mcycle_wmask   = rvfi_csr_mcycle_wmask();
+        rec.csr_mcycle_wdata   = rvfi_csr_mcycle_wdata();
+        rec.csr_minstret_wmask = rvfi_csr_minstret_wmask();
+        rec.csr_minstret_wdata = rvfi_csr_minstret_wdata();
+        return CommitStatus::Commit;
+      }
+      if (trap()) {
+        rec.pc_r = rvfi_pc_rdata();
+        rec.insn = rvfi_insn();
+        rec.trap = 1u;
+        return CommitStatus::Trap;
+      }
+    }
+    return CommitStatus::Budget;
+  }
+
   // ========================================================================
   // RVFI (RISC-V Formal Verification Interface) Accessors
   // ========================================================================
@@ -280,6 +437,26 @@ public:
    * @see rvfi_mem_rmask() for mask interpretation
    */
   virtual uint32_t rvfi_mem_wmask() const = 0;
+
+  /**
+   * @brief Get the data written to memory (optional)
+   * 
+   * Lane-aligned like the bus: byte i of the word at mem_addr is bits
+   * [8i+7:8i]. Only meaningful when rvfi_mem_wmask() is non-zero.
+   * 
+   * @return Store data (default: 0 = not tracked)
+   */
+  virtual uint32_t rvfi_mem_wdata() const { return 0; }
+
+  /**
+   * @brief Get the data read from memory (optional)
+   * 
+   * Lane-aligned like rvfi_mem_wdata(). Only meaningful when
+   * rvfi_mem_rmask() is non-zero.
+   * 
+   * @return Load data (default: 0 = not tracked)
+   */
+  virtual uint32_t rvfi_mem_rdata() const { return 0; }
   
   // ========================================================================
   // Optional RVFI CSR (Control and Status Register) Tracking
@@ -9,12 +9,17 @@
  * 
  * All checks return true if a crash was detected and logged, allowing
  * the caller to terminate execution immediately.
+ * 
+ * Per-commit checks take the CommitRec filled by CpuIface::run_until_commit()
+ * and are only meant to be called for a retired instruction, so they never
+ * query the CPU themselves.
  */
 
 #pragma once
 
 #include "CpuIface.hpp"
 #include "CrashLogger.hpp"
+#include "InputView.hpp"
 #include <cstdint>
 #include <vector>
 
@@ -26,14 +31,14 @@ namespace crash_detection {
  * RISC-V mandates that x0 must always read as zero. Any attempt to
  * write a non-zero value to x0 indicates a hardware bug.
  * 
- * @param cpu CPU interface providing RVFI signals
+ * @param rec Commit record of the retired instruction
  * @param logger Crash logger for recording violations
  * @param cyc Current execution cycle number
  * @param input Fuzzer input that triggered the violation
  * @return true if violation detected and logged, false otherwise
  */
-bool check_x0_write(const CpuIface* cpu, const CrashLogger& logger, 
-                    unsigned cyc, const std::vector<unsigned char>& input);
+bool check_x0_write(const CommitRec& rec, const CrashLogger& logger, 
+                    unsigned cyc, InputView input);
 
 /**
  * @brief Check for misaligned PC values
@@ -44,14 +49,14 @@ bool check_x0_write(const CpuIface* cpu, const CrashLogger& logger,
  * 
  * This check enforces 2-byte minimum alignment (odd PC is always illegal).
  * 
- * @param cpu CPU interface providing RVFI signals
+ * @param rec Commit record of the retired instruction
  * @param logger Crash logger for recording violations
  * @param cyc Current execution cycle number
  * @param input Fuzzer input that triggered the violation
  * @return true if violation detected and logged, false otherwise
  */
-bool check_pc_misaligned(const CpuIface* cpu, const CrashLogger& logger,
-                         unsigned cyc, const std::vector<unsigned char>& input);
+bool check_pc_misaligned(const CommitRec& rec, const CrashLogger& logger,
+                         unsigned cyc, InputView input);
 
 /**
  * @brief Check for misaligned or irregular memory loads
@@ -65,14 +70,14 @@ bool check_pc_misaligned(const CpuIface* cpu, const CrashLogger& logger,
  * Also checks that the byte mask (rmask) is contiguous. Non-contiguous
  * masks indicate hardware bugs.
  * 
- * @param cpu CPU interface providing RVFI signals
+ * @param rec Commit record of the retired instruction
  * @param logger Crash logger for recording violations
  * @param cyc Current execution cycle number
  * @param input Fuzzer input that triggered the violation
  * @return true if violation detected and logged, false otherwise
  */
-bool check_mem_align_load(const CpuIface* cpu, const CrashLogger& logger,
-                          unsigned cyc, const std::vector<unsigned char>& input);
+bool check_mem_align_load(const CommitRec& rec, const CrashLogger& logger,
+                          unsigned cyc, InputView input);
 
 /**
  * @brief Check for misaligned or irregular memory stores
@@ -86,14 +91,14 @@ bool check_mem_align_load(const CpuIface* cpu, const CrashLogger& logger,
  * Also checks that the byte mask (wmask) is contiguous. Non-contiguous
  * masks indicate hardware bugs.
  * 
- * @param cpu CPU interface providing RVFI signals
+ * @param rec Commit record of the retired instruction
  * @param logger Crash logger for recording violations
  * @param cyc Current execution cycle number
  * @param input Fuzzer input that triggered the violation
  * @return true if violation detected and logged, false otherwise
  */
-bool check_mem_align_store(const CpuIface* cpu, const CrashLogger& logger,
-                           unsigned cyc, const std::vector<unsigned char>& input);
+bool check_mem_align_store(const CommitRec& rec, const CrashLogger& logger,
+                           unsigned cyc, InputView input);
 
 /**
  * @brief Check for execution timeout
@@ -109,7 +114,7 @@ bool check_mem_align_store(const CpuIface* cpu, const CrashLogger& logger,
  * @return true if timeout detected and logged, false otherwise
  */
 bool check_timeout(unsigned cyc, unsigned max_cycles, const CpuIface* cpu,
-                   const CrashLogger& logger, const std::vector<unsigned char>& input);
+                   const CrashLogger& logger, InputView input);
 
 /**
  * @brief Check for PC stagnation (infinite loop detection)
@@ -121,7 +126,7 @@ bool check_timeout(unsigned cyc, unsigned max_cycles, const CpuIface* cpu,
  * This function maintains internal state to track the last PC and
  * consecutive count. It should be called on every valid commit.
  * 
- * @param cpu CPU interface providing RVFI signals
+ * @param rec Commit record of the retired instruction
  * @param logger Crash logger for recording stagnation
  * @param cyc Current execution cycle number
  * @param input Fuzzer input that triggered the stagnation
@@ -131,8 +136,8 @@ bool check_timeout(unsigned cyc, unsigned max_cycles, const CpuIface* cpu,
  * @param stagnation_count Reference to consecutive count (maintains state)
  * @return true if stagnation detected and logged, false otherwise
  */
-bool check_pc_stagnation(const CpuIface* cpu, const CrashLogger& logger,
-                         unsigned cyc, const std::vector<unsigned char>& input,
+bool check_pc_stagnation(const CommitRec& rec, const CrashLogger& logger,
+                         unsigned cyc, InputView input,
                          unsigned stagnation_limit, uint32_t& last_pc,
                          bool& last_pc_valid, unsigned& stagnation_count);
 
@@ -141,14 +146,15 @@ bool check_pc_stagnation(const CpuIface* cpu, const CrashLogger& logger,
  * 
  * Detects when the CPU signals a trap condition via RVFI. Traps indicate
  * exceptions, illegal instructions, or other abnormal execution events.
+ * Also used for CommitStatus::Trap, where only pc_r, insn and trap are set.
  * 
- * @param cpu CPU interface providing RVFI signals
+ * @param rec Commit record of the retired instruction
  * @param logger Crash logger for recording trap
  * @param cyc Current execution cycle number
  * @param input Fuzzer input that triggered the trap
  * @return true if trap detected and logged, false otherwise
  */
-bool check_trap(const CpuIface* cpu, const CrashLogger& logger,
-                unsigned cyc, const std::vector<unsigned char>& input);
+bool check_trap(const CommitRec& rec, const CrashLogger& logger,
+                unsigned cyc, InputView input);
 
 } // namespace crash_detection
@@ -11,6 +11,7 @@
 
 #pragma once
 #include "HarnessConfig.hpp"
+#include "InputView.hpp"
 #include "Utils.hpp"
 #include <cstdint>
 #include <exception>
@@ -90,6 +91,26 @@ public:
     utils::ensure_dir(cfg_.crash_dir);
   }
 
+  /**
+   * @brief Construct a CrashLogger whose artifact names carry a tag
+   * 
+   * Used when several loggers share one crash directory in the same process
+   * (one per batch worker) and each may report many crashes. The tag and a
+   * per-logger sequence number are appended to the base name so two crashes
+   * with the same reason, second and cycle never overwrite each other.
+   * 
+   * @param cfg Harness configuration containing crash_dir and objdump paths
+   * @param tag Short unique tag, e.g. "w3" for worker 3
+   * 
+   * Generated files:
+   * @code
+   *   crash_trap_20250111T143052_cyc1234_w3_17.bin
+   * @endcode
+   */
+  CrashLogger(const HarnessConfig &cfg, const std::string &tag) : cfg_(cfg), tag_(tag) {
+    utils::ensure_dir(cfg_.crash_dir);
+  }
+
   /**
    * @brief Write crash artifacts (binary input + comprehensive log)
    * 
@@ -175,14 +196,17 @@ public:
                   uint32_t pc,
                   uint32_t insn,
                   unsigned cycle,
-                  const std::vector<unsigned char> &input,
+                  InputView input,
                   const std::string &details = "") const {
 
     const std::string base = makeBaseName(reason, cycle);
+    last_base_ = base;
     const std::string bin_path = base + ".bin";
     const std::string log_path = base + ".log";
 
-    writeFile(bin_path, input);
+    // The input may be AFL++ shared memory; copy it only now that it is kept
+    const std::vector<unsigned char> bytes = input.to_vector();
+    writeFile(bin_path, bytes);
 
     std::string log;
     log.reserve(4096);
@@ -192,10 +216,10 @@ public:
     log += "Instruction: 0x" + hex32(insn) + "\n\n";
 
     log += "Hexdump:\n";
-    log += utils::hexdump(input);
+    log += utils::hexdump(bytes);
     log += "\n";
 
-    std::string dasm = utils::disassemble(input, cfg_.objdump, cfg_.xlen);
+    std::string dasm = utils::disassemble(bytes, cfg_.objdump, cfg_.xlen);
     if (!dasm.empty()) {
       log += "Disassembly:\n";
       log += dasm;
@@ -213,12 +237,50 @@ public:
     writeTextAtomically(log_path, log);
   }
 
+  /**
+   * @brief Path prefix of the last crash written, without extension
+   * 
+   * Lets callers attach more files to a finding after writeCrash()
+   * returned, e.g. base + ".dut.trace". Empty until the first crash, or
+   * since clearLastCrash().
+   */
+  const std::string &lastCrashBase() const { return last_base_; }
+
+  /**
+   * @brief Forget the last crash (call at the start of every input)
+   */
+  void clearLastCrash() { last_base_.clear(); }
+
+  /**
+   * @brief Remove the artifacts of a crash that turned out not to be the finding
+   * 
+   * Used when an earlier event of the same run is reported instead, e.g.
+   * a divergence found in the DIFF_MODE=digest window after a later trap
+   * was already written.
+   * 
+   * @param base Path prefix returned by lastCrashBase()
+   */
+  void discardCrash(const std::string &base) {
+    if (base.empty()) return;
+    std::error_code ec;
+    std::filesystem::remove(base + ".bin", ec);
+    std::filesystem::remove(base + ".log", ec);
+    if (base == last_base_) last_base_.clear();
+  }
+
 private:
   /**
    * @brief Harness configuration (crash directory, objdump path, etc.)
    */
   HarnessConfig cfg_;
 
+  /**
+   * @brief Optional name tag and running crash count (tagged loggers only)
+   */
+  std::string tag_;
+  mutable unsigned seq_ = 0;
+  mutable std::string last_base_;
+
   /**
    * @brief Convert uint32_t to zero-padded 8-digit hex string
    * 
@@ -243,8 +305,12 @@ private:
    */
   std::string makeBaseName(const std::string &reason, unsigned cycle) const {
     std::string ts = utils::timestamp_now();
-    return cfg_.crash_dir + "/crash_" + reason + "_" + ts + "_cyc" +
-           std::to_string(cycle);
+    std::string base = cfg_.crash_dir + "/crash_" + reason + "_" + ts + "_cyc" +
+                       std::to_string(cycle);
+    if (!tag_.empty()) {
+      base += "_" + tag_ + "_" + std::to_string(seq_++);
+    }
+    return base;
   }
 
   /**
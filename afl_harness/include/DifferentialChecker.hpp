@@ -2,16 +2,34 @@
 
 #include "CpuIface.hpp"
 #include "CrashLogger.hpp"
+#include "InputView.hpp"
+#include "MemDigest.hpp"
 #include "Trace.hpp"
 #include <vector>
 #include <cstdint>
 
 /// @brief Differential testing checker for DUT vs Golden model
+/// @note Detailed mode (default) compares PC, regfile, memory access and CSRs on
+///       every commit. Digest mode (DIFF_MODE=digest) folds each side's PC,
+///       register writes, memory accesses and CSR counters into a running digest
+///       and compares the digests every DIFF_CHECKPOINT commits and at flush();
+///       on a mismatch the window is re-checked in detailed mode from the last
+///       checkpoint's shadow state, so reports are identical.
+/// @note MEM_DIGEST=true also compares the memory written by the DUT bus with
+///       the golden model's stores when a run exits gracefully (check_memory_image())
 class DifferentialChecker {
 public:
   DifferentialChecker();
 
-  /// @brief Reset shadow state (regfiles, CSRs)
+  /// @brief Compare digests every @p checkpoint commits; 0 selects detailed mode
+  void set_checkpoint(unsigned checkpoint);
+
+  /// @brief Track golden stores for check_memory_image()
+  /// @param tohost_addr Word left out of the comparison: the DUT exits on the
+  ///        tohost store before it retires, so the golden side never sees it
+  void enable_memory_digest(uint32_t tohost_addr);
+
+  /// @brief Reset shadow state (regfiles, CSRs, digest window, golden stores)
   void reset();
 
   /// @brief Update DUT shadow state after a commit
@@ -22,20 +40,35 @@ public:
   /// @param rec Golden commit record
   void update_golden_state(const CommitRec& rec);
 
-  /// @brief Update DUT CSR state from RVFI interface
-  /// @param cpu CPU interface for reading CSR changes
-  void update_dut_csrs(CpuIface* cpu);
+  /// @brief Update DUT CSR state from the RVFI CSR fields of a commit
+  /// @param rec DUT commit record (csr_* fields)
+  void update_dut_csrs(const CommitRec& rec);
 
-  /// @brief Compare DUT vs Golden state and crash if mismatch detected
+  /// @brief Compare DUT vs Golden state and write a crash report on mismatch
   /// @param dut_rec DUT commit record
   /// @param gold_rec Golden commit record
   /// @param logger Crash logger for writing divergence reports
   /// @param cyc Current cycle count
   /// @param input Input data for crash reproduction
-  /// @return True if divergence detected (will abort)
+  /// @return True if divergence detected; the caller decides whether to abort
+  /// @note Digest mode only records the pair; a divergence in the window is
+  ///       reported at the next checkpoint, with the cycle of the diverging commit
   bool check_divergence(const CommitRec& dut_rec, const CommitRec& gold_rec,
                         CrashLogger& logger, unsigned cyc,
-                        const std::vector<unsigned char>& input);
+                        InputView input);
+
+  /// @brief Check the commits recorded since the last checkpoint (digest mode)
+  /// @note Call once the run ends without a crash; a no-op in detailed mode
+  /// @return True if a divergence was found and reported
+  bool flush(CrashLogger& logger, InputView input);
+
+  /// @brief Compare the memory the DUT wrote with the golden stores
+  /// @param dut Bus writes of this run (CpuIface::write_digest()); null skips the check
+  /// @note Call on graceful exit only. Skipped unless every retired DUT
+  ///       commit was paired with a golden one, since unpaired stores differ
+  /// @return True if the written images differ; a crash report was written
+  bool check_memory_image(const MemDigest* dut, CrashLogger& logger, unsigned cyc,
+                          InputView input);
 
 private:
   // Shadow regfiles for comparison (x0..x31)
@@ -48,19 +81,66 @@ private:
   uint64_t dut_minstret_;
   uint64_t gold_minstret_;
 
+  // Digest mode: 4 independent lanes (PC, rd write, memory access, CSR
+  // counters), the shadow state at the last checkpoint, and the fields the
+  // detailed checks read for each commit since, for the re-check
+  struct WindowEntry {
+    uint32_t cyc;
+    uint32_t dut_pc_r;
+    uint32_t dut_insn;
+    uint32_t pc_w[2];        ///< [0] DUT, [1] golden
+    uint32_t rd_wdata[2];
+    uint32_t mem_addr[2];
+    uint32_t gold_mem_wdata;
+    uint32_t gold_mem_rdata;
+    uint8_t rd_addr[2];
+    uint8_t dut_rmask;
+    uint8_t dut_wmask;
+    uint8_t gold_mem_kind;   ///< Bit 0 load, bit 1 store
+    uint64_t dut_mcycle;     ///< DUT counters after the commit
+    uint64_t dut_minstret;
+  };
+  unsigned checkpoint_;
+  uint64_t dut_digest_[4];
+  uint64_t gold_digest_[4];
+  std::vector<WindowEntry> window_;
+  size_t window_len_;
+  uint32_t ckpt_dut_regs_[32];
+  uint32_t ckpt_gold_regs_[32];
+  uint64_t ckpt_dut_mcycle_;
+  uint64_t ckpt_dut_minstret_;
+  uint64_t ckpt_gold_mcycle_;
+  uint64_t ckpt_gold_minstret_;
+
+  bool check_divergence_detailed(const CommitRec& dut, const CommitRec& gold,
+                                 CrashLogger& logger, unsigned cyc,
+                                 InputView input);
+  void save_checkpoint();
+
+  // MEM_DIGEST: golden stores of paired commits, and enough bookkeeping to
+  // tell whether the DUT retired anything the golden side did not see
+  bool mem_digest_;
+  uint32_t tohost_word_;
+  MemDigest gold_writes_;
+  unsigned dut_commits_;
+  unsigned paired_;
+  uint32_t last_pc_;
+  uint32_t last_insn_;
+  bool check_window(CrashLogger& logger, InputView input);
+
   bool check_pc_divergence(const CommitRec& dut, const CommitRec& gold,
                            CrashLogger& logger, unsigned cyc,
-                           const std::vector<unsigned char>& input);
+                           InputView input);
 
   bool check_regfile_divergence(const CommitRec& dut, const CommitRec& gold,
                                 CrashLogger& logger, unsigned cyc,
-                                const std::vector<unsigned char>& input);
+                                InputView input);
 
   bool check_memory_divergence(const CommitRec& dut, const CommitRec& gold,
                                CrashLogger& logger, unsigned cyc,
-                               const std::vector<unsigned char>& input);
+                               InputView input);
 
   bool check_csr_divergence(const CommitRec& dut, const CommitRec& gold,
                             CrashLogger& logger, unsigned cyc,
-                            const std::vector<unsigned char>& input);
+                            InputView input);
 };
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "CpuIface.hpp"
+#include "CrashLogger.hpp"
+#include "DifferentialChecker.hpp"
+#include "DutExit.hpp"
+#include "GoldenModel.hpp"
+#include "HarnessConfig.hpp"
+#include "InputView.hpp"
+#include "Trace.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// @brief How one input ended
+enum class ExecOutcome {
+  Graceful,  ///< Program exited cleanly (finish, tohost, ecall, Spike done)
+  Crash,     ///< A crash check or divergence fired; artifacts already written
+  Timeout    ///< MAX_CYCLES reached; timeout artifacts already written
+};
+
+/// @brief Per-input progress of the DUT execution loop
+struct ExecutionState {
+  unsigned cyc;
+  ExitReason exit_reason;
+  bool graceful_exit;
+  uint32_t last_progress_pc;
+  bool last_progress_valid;
+  unsigned stagnation_count;
+  unsigned retired;  ///< Instructions retired so far (for cycles-per-instruction)
+};
+
+/// @brief Everything one DUT needs to run inputs; one per thread in batch mode
+struct ExecutionContext {
+  CpuIface* cpu;
+  const HarnessConfig& cfg;
+  CrashLogger& logger;
+  TraceWriter& tracer;
+  GoldenModel& golden;
+  DifferentialChecker& diff_checker;
+  bool trace_enabled;
+};
+
+namespace execution {
+
+/// @brief Install handlers that turn SIGSEGV/SIGILL/SIGBUS/SIGABRT into a crash report
+void install_signal_handlers();
+
+/// @brief Step the DUT until exit, crash or MAX_CYCLES
+/// @return True if a crash check or divergence fired (crash already logged)
+bool run_execution_loop(const ExecutionContext& ctx, InputView input, ExecutionState& state);
+
+/// @brief Reset the DUT, load one input and run it to completion
+/// @param ctx DUT, checkers and loggers to use
+/// @param input Bytes the DUT and the golden model execute (may be AFL++
+///              shared memory); copied only when a crash report is written
+/// @return Outcome; the caller decides whether a crash aborts the process
+ExecOutcome run_one_input(const ExecutionContext& ctx, InputView input);
+
+} // namespace execution
@@ -0,0 +1,106 @@
+/**
+ * @file GoldenCache.hpp
+ * @brief Node-wide, mmap-backed cache of golden commit streams
+ *
+ * AFL++ executes the same input many times (calibration, trimming, re-runs
+ * after syncing from other instances). The golden commit stream of an input
+ * only depends on its bytes and the golden configuration, so it is computed
+ * once and stored in a shared file (typically under /dev/shm) that every
+ * harness process on the node maps.
+ *
+ * Layout: a header, a direct-mapped slot table and a data area used as a
+ * ring log. Insertion reserves space by advancing one atomic cursor, writes
+ * the entry and then publishes its position in the slot with a release
+ * store. Lookup is optimistic: it copies the entry, then checks that the
+ * cursor has not lapped it meanwhile and that the payload checksum matches.
+ * Neither side takes a lock; the oldest entries are evicted as the log
+ * wraps, so the file never grows beyond its initial size.
+ */
+
+#pragma once
+
+#include "Trace.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// @brief Appends CommitRecs to a compact byte stream (13 bytes per straight-line ALU commit)
+class CommitEncoder {
+public:
+  void reset() { prev_pc_ = 0; }
+  void append(const CommitRec& rec, std::vector<uint8_t>& out);
+
+private:
+  uint32_t prev_pc_ = 0;
+};
+
+/// @brief Reads back a stream written by CommitEncoder
+class CommitDecoder {
+public:
+  void reset(const uint8_t* data, size_t len) { p_ = data; end_ = data + len; prev_pc_ = 0; }
+
+  /// @return False at the end of the stream (or on a malformed record)
+  bool next(CommitRec& rec);
+
+private:
+  const uint8_t* p_ = nullptr;
+  const uint8_t* end_ = nullptr;
+  uint32_t prev_pc_ = 0;
+};
+
+/**
+ * @class GoldenCache
+ * @brief Shared content-addressed store: 128-bit key -> encoded commit stream
+ *
+ * Example usage:
+ * @code
+ *   GoldenCache cache;
+ *   cache.open("/dev/shm/hwfuzz_golden.cache", 256u << 20);
+ *   uint64_t key = GoldenCache::hash(data, len, config_seed);
+ *   uint64_t check = GoldenCache::hash(data, len, ~config_seed);
+ *   if (cache.lookup(key, check, entry)) { ... replay entry.payload ... }
+ *   else { ... run the golden model ...; cache.insert(key, check, entry); }
+ * @endcode
+ *
+ * @note The key is 64 bits; @p check is a second, independent hash stored in
+ *       the entry, so a false hit needs a 128-bit collision
+ */
+class GoldenCache {
+public:
+  struct Entry {
+    std::vector<uint8_t> payload;   ///< CommitEncoder stream
+    uint32_t commits = 0;
+    uint32_t flags = 0;             ///< Caller defined (GoldenModel: bit 0 = finished)
+  };
+
+  GoldenCache() = default;
+  ~GoldenCache() { close(); }
+
+  GoldenCache(const GoldenCache&) = delete;
+  GoldenCache& operator=(const GoldenCache&) = delete;
+
+  /// @brief Map (creating if needed) the cache file
+  /// @param size_bytes Total file size for a new cache; an existing one keeps its size
+  bool open(const std::string& path, size_t size_bytes);
+  void close();
+  bool is_open() const { return base_ != nullptr; }
+
+  /// @brief Fast 64-bit hash for keys (not cryptographic)
+  static uint64_t hash(const void* data, size_t len, uint64_t seed);
+
+  /// @brief Copy the entry for @p key into @p out
+  /// @return False on a miss, an evicted entry or a torn read
+  bool lookup(uint64_t key, uint64_t check, Entry& out) const;
+
+  /// @brief Store @p entry under @p key, replacing whatever used its slot
+  /// @return False if the cache is closed or the entry is too large
+  bool insert(uint64_t key, uint64_t check, const Entry& entry);
+
+private:
+  struct Header;
+
+  uint8_t* base_ = nullptr;
+  size_t map_size_ = 0;
+  Header* header_ = nullptr;
+};
@@ -1,48 +1,172 @@
 #pragma once
 
+#include "GoldenCache.hpp"
+#include "InputView.hpp"
+#include "Rv32Iss.hpp"
 #include "SpikeProcess.hpp"
 #include "Trace.hpp"
+#include "TraceFile.hpp"
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <memory>
 
-/// @brief Manages Spike golden model integration for differential testing
+/// @brief Manages the golden model (Spike or the built-in ISS) for differential testing
+/// @note GOLDEN_MODE=live runs Spike per input, builtin runs Rv32Iss in-process
+///       and replay reads a recorded trace (GOLDEN_REPLAY); GOLDEN_RECORD saves
+///       live runs for it
+/// @note GOLDEN_ASYNC=1 runs any of them on a separate thread that starts with
+///       initialize() and hands commits to next_commit() through an SPSC ring
+/// @note GOLDEN_CACHE=<file> shares finished commit streams between all harness
+///       processes on the node; a repeated input replays from it without a backend
 class GoldenModel {
 public:
   GoldenModel();
   ~GoldenModel();
 
-  /// @brief Initialize golden model from environment configuration
+  /// @brief Read GOLDEN_MODE, SPIKE_*, TRACE_MODE and the memory map from the environment
+  /// @note Input independent; the harness calls it once before __AFL_INIT()
+  void configure();
+
+  /// @brief Cap every golden run at the DUT's own limits
+  /// @param max_commits Instruction budget (MAX_CYCLES: the DUT retires at most one per cycle)
+  /// @param stagnation_limit Consecutive commits at one PC (PC_STAGNATION_LIMIT); 0 disables
+  /// @note A run that hits a limit ends early; for Spike that means SIGKILL, not a wait
+  void set_limits(unsigned max_commits, unsigned stagnation_limit);
+
+  /// @brief Start the golden model for one input
+  /// @note Safe to call once per input; any previous Spike run is stopped first
+  /// @note Asynchronous mode only queues the start and returns true; call it
+  ///       before the DUT reset so the two overlap
+  /// @note Calls configure() on first use if the caller did not
   /// @param input Raw binary input data
   /// @param trace_dir Trace directory for golden.trace output
   /// @return True if golden model is ready for use
-  bool initialize(const std::vector<unsigned char>& input, const char* trace_dir);
+  bool initialize(InputView input, const char* trace_dir);
 
   /// @brief Check if golden model is active and ready
   bool is_ready() const { return golden_ready_; }
 
-  /// @brief Get next commit from Spike golden model
+  /// @brief Get next commit from the golden model
   /// @param rec Output commit record
   /// @return True if commit was retrieved successfully
   bool next_commit(CommitRec& rec);
 
+  /// @brief True once the golden model has run the program to a clean exit
+  /// @note Spike: process exited with status 0; builtin: tohost store or ECALL;
+  ///       replay: the recorded run finished and every commit was consumed
+  bool finished() const;
+
+  /// @brief True when GOLDEN_MODE=builtin selects the in-process ISS
+  bool builtin() const { return backend_ == Backend::Builtin; }
+
+  /// @brief False when golden commits carry no store data (CSV replay traces)
+  bool has_store_data() const {
+    return backend_ != Backend::Replay || replay_trace_.format() != TraceFile::Format::Csv;
+  }
+
   /// @brief Stop the golden model process
   void stop();
 
   /// @brief Get the Spike process for direct access
   SpikeProcess& spike() { return spike_; }
 
+  /// @brief Append the last run's raw Spike log to SPIKE_LOG_FILE
+  /// @note Call after stop() for a run that was reported as a crash or divergence;
+  ///       only the last SPIKE_LOG_RING instructions are kept
+  void dump_spike_log(const char* reason);
+
+  /// @brief TRACE_MODE=ring: write the recorded golden commits to golden.trace and @p path
+  /// @note Call after stop(), like dump_spike_log()
+  void dump_trace(const std::string& path) const { golden_tracer_.dump_ring(path); }
+
   /// @brief Write golden trace if enabled
   void write_trace(const CommitRec& rec);
 
-  /// @brief Get temporary ELF path (for debugging)
+  /// @brief Get the ELF path handed to Spike (for debugging)
   const std::string& elf_path() const { return tmp_elf_; }
 
 private:
+  bool start_backend(InputView input);
+  bool fetch_commit(CommitRec& rec);
+  bool pull_commit(CommitRec& rec);
+  bool fetch_complete() const;
+  bool finished_backend() const;
+  bool start_spike(InputView input);
+  bool build_elf(InputView input);
+  bool start_builtin(InputView input);
+  bool start_replay(InputView input);
+  bool within_limits(const CommitRec& rec);
+  void start_async(InputView input);
+  void cancel_async();
+  void async_main();
+  void update_cache_seed();
+  void record_commit(const CommitRec& rec);
+  void store_recorded_run();
+
+  enum class Backend { Spike, Builtin, Replay };
+
   SpikeProcess spike_;
+  Rv32Iss iss_;
   TraceWriter golden_tracer_;
   std::string tmp_elf_;
   bool golden_ready_;
   bool trace_enabled_;
   std::string golden_mode_;
+
+  // Cached environment (filled by configure())
+  bool configured_;
+  bool trace_requested_;
+  Backend backend_;
+  std::string spike_bin_;
+  std::string spike_isa_;
+  std::string pk_bin_;
+  std::string spike_log_path_;
+  bool toolchain_elf_;      // SPIKE_ELF_BUILDER=toolchain: objcopy + ld per input
+  std::string replay_path_; // GOLDEN_REPLAY: trace file, or directory of <input key>.trace
+  std::string record_dir_;  // GOLDEN_RECORD: where live runs are saved as <input key>.trace
+
+  // GOLDEN_MODE=replay: the loaded trace is kept while its file is unchanged
+  TraceFile replay_trace_;
+  std::string replay_loaded_;   // Path + size + mtime of replay_trace_
+  size_t replay_pos_;
+
+  // In-memory ELF image, created on first use and rewritten for every input
+  int elf_fd_;
+  std::string elf_fd_path_;
+  uint32_t elf_load_addr_;  // PROGADDR_RESET (LMA and entry)
+  uint32_t elf_ram_base_;   // RAM_BASE (VMA of the image, as link.ld places .data)
+
+  // Memory map for the built-in ISS (same variables the DUT uses)
+  uint32_t load_base_;
+  uint32_t stack_addr_;
+  size_t max_image_;
+
+  // Per-run limits (set_limits()) and progress towards them
+  unsigned max_commits_;
+  unsigned stagnation_limit_;
+  unsigned commits_;
+  unsigned same_pc_count_;
+  uint32_t last_pc_;
+  bool pull_complete_;  // pull_commit() ended on the run's real end (EOF, exit, limit)
+
+  // GOLDEN_ASYNC=1; the backend members above then belong to the golden
+  // thread between initialize() and stop()
+  struct AsyncState;
+  bool async_requested_;
+  std::unique_ptr<AsyncState> async_;
+
+  // GOLDEN_CACHE / GOLDEN_RECORD: Record captures the running backend's stream
+  // for storing at stop(), Replay serves next_commit() from a cached entry
+  enum class CacheState { Off, Record, Replay };
+  GoldenCache cache_;
+  uint64_t cache_seed_;       // Hash of everything besides the input that shapes the stream
+  CacheState cache_state_;
+  uint64_t cache_key_;
+  uint64_t cache_check_;
+  std::string record_path_;   // GOLDEN_RECORD file of the current input
+  bool cache_complete_;       // Recorded stream reached the end of the run
+  GoldenCache::Entry cache_entry_;
+  CommitEncoder cache_encoder_;
+  CommitDecoder cache_decoder_;
 };
@@ -29,6 +29,9 @@ struct HarnessConfig {
   uint32_t tohost_addr = 0;           ///< Memory address for tohost register (from TOHOST_ADDR environment variable)
   unsigned pc_stagnation_limit = 512; ///< Max instructions at same PC before timeout (from PC_STAGNATION_LIMIT in harness.conf)
   unsigned max_program_words = 256;   ///< Maximum program size in 32-bit words (from MAX_PROGRAM_WORDS in harness.conf)
+  unsigned persistent_iters = 1000;   ///< Inputs per process in AFL++ persistent mode (from PERSISTENT_ITERS in harness.conf)
+  unsigned diff_checkpoint = 0;       ///< Commits per digest comparison, 0 = check every commit (from DIFF_MODE/DIFF_CHECKPOINT in harness.conf)
+  bool mem_digest = false;            ///< Compare DUT and golden written memory at exit (from MEM_DIGEST in harness.conf)
 
   /**
    * @brief Parse .conf file (KEY=value format) into map
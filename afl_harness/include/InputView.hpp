@@ -0,0 +1,50 @@
+/**
+ * @file InputView.hpp
+ * @brief Non-owning view of the bytes of one fuzzer input
+ *
+ * The harness hands the same input to the DUT loader, the golden model and
+ * the crash checks. Under AFL++ the bytes live in the shared-memory testcase
+ * buffer; passing a view instead of a std::vector avoids copying them for
+ * every execution. CrashLogger copies the bytes only when it writes a finding.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @class InputView
+ * @brief Pointer and length of an input the caller keeps alive
+ *
+ * Converts implicitly from a std::vector, so callers holding a vector
+ * (file and stdin input, batch mode, tests) pass it unchanged.
+ *
+ * Example usage:
+ * @code
+ *   InputView input(__AFL_FUZZ_TESTCASE_BUF, __AFL_FUZZ_TESTCASE_LEN);
+ *   execution::run_one_input(ctx, input);
+ *   std::vector<unsigned char> copy = input.to_vector();  // Only for artifacts
+ * @endcode
+ *
+ * @note The view does not extend the lifetime of the bytes
+ */
+class InputView {
+public:
+  InputView() = default;
+  InputView(const unsigned char* data, size_t size) : data_(data), size_(size) {}
+  InputView(const std::vector<unsigned char>& v) : data_(v.data()), size_(v.size()) {}
+
+  const unsigned char* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const unsigned char* begin() const { return data_; }
+  const unsigned char* end() const { return data_ + size_; }
+
+  /// Copy of the bytes, for code that needs to own them.
+  std::vector<unsigned char> to_vector() const { return std::vector<unsigned char>(begin(), end()); }
+
+private:
+  const unsigned char* data_ = nullptr;
+  size_t size_ = 0;
+};
@@ -0,0 +1,161 @@
+/**
+ * @file MemDigest.hpp
+ * @brief Incremental digest of the memory a run has written
+ *
+ * Both the DUT and the golden model start from the same memory image (the
+ * input at the reset vector, zeroes elsewhere), so their final memory can
+ * only differ in bytes that were written. MemDigest keeps the last value of
+ * every written byte, grouped per aligned 32-bit word, and a 64-bit digest
+ * over them that is updated on each store. Comparing two digests compares
+ * the full written memory image without dumping or diffing any RAM.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class MemDigest
+ * @brief Written-byte image of one run and its order-independent digest
+ *
+ * The digest is the XOR of a strong hash of each written word (address,
+ * byte mask, byte values). A store removes the word's old hash and adds
+ * the new one, so the digest only depends on the final contents, not on
+ * the order or number of stores.
+ *
+ * Words live in an open-addressing table that grows as needed and is
+ * cleared in O(1) by bumping a generation count, so runs after the first
+ * do not allocate.
+ *
+ * Example usage:
+ * @code
+ *   MemDigest dut, gold;
+ *   dut.store(0x80040000, 0x000000ff, 0x1);       // sb: byte lane 0
+ *   gold.store(0x80040000, 0x123456ff, 0x1);      // unwritten lanes ignored
+ *   if (dut.value() != gold.value()) { ... }
+ *   dut.reset();
+ * @endcode
+ */
+class MemDigest {
+public:
+  struct Word {
+    uint32_t addr;   ///< Aligned word address
+    uint32_t data;   ///< Written bytes; unwritten lanes are zero
+    uint8_t  mask;   ///< Bit i: byte i was written
+  };
+
+  MemDigest() : slots_(kInitialSlots) {}
+
+  /// @brief Forget every write (O(1))
+  void reset() {
+    if (++gen_ == 0) {  // Wrapped: stale entries could look current
+      for (Slot& s : slots_) s.gen = 0;
+      gen_ = 1;
+    }
+    used_ = 0;
+    digest_ = 0;
+  }
+
+  /// @brief Record a write of the lanes in @p wstrb of @p data to the word at @p addr
+  void store(uint32_t addr, uint32_t data, uint8_t wstrb) {
+    wstrb &= 0xF;
+    if (!wstrb) return;
+    addr &= ~0x3u;
+    if ((used_ + 1) * 2 > slots_.size()) grow();
+    Slot& s = find(addr);
+    if (s.gen == gen_) {
+      digest_ ^= hash(s.word);
+    } else {
+      s.gen = gen_;
+      s.word = Word{addr, 0, 0};
+      ++used_;
+    }
+    const uint32_t lanes = lane_mask(wstrb);
+    s.word.data = (s.word.data & ~lanes) | (data & lanes);
+    s.word.mask |= wstrb;
+    digest_ ^= hash(s.word);
+  }
+
+  /// @brief Digest of everything written since reset(); 0 if nothing was
+  uint64_t value() const { return digest_; }
+
+  /// @brief Digest as if the word at @p addr had never been written
+  uint64_t value_without(uint32_t addr) const {
+    const Word* w = lookup(addr);
+    return w ? digest_ ^ hash(*w) : digest_;
+  }
+
+  /// @brief The written state of the word at @p addr, or nullptr
+  const Word* lookup(uint32_t addr) const {
+    addr &= ~0x3u;
+    for (size_t i = index(addr);; i = (i + 1) & (slots_.size() - 1)) {
+      const Slot& s = slots_[i];
+      if (s.gen != gen_) return nullptr;
+      if (s.word.addr == addr) return &s.word;
+    }
+  }
+
+  /// @brief Every written word, in table order
+  template <typename F>
+  void for_each(F f) const {
+    for (const Slot& s : slots_) {
+      if (s.gen == gen_) f(s.word);
+    }
+  }
+
+  /// @brief Number of distinct words written
+  size_t words() const { return used_; }
+
+  /// @brief Bit mask of the byte lanes set in @p wstrb
+  static uint32_t lane_mask(uint8_t wstrb) {
+    return (wstrb & 1 ? 0x000000ffu : 0) | (wstrb & 2 ? 0x0000ff00u : 0) |
+           (wstrb & 4 ? 0x00ff0000u : 0) | (wstrb & 8 ? 0xff000000u : 0);
+  }
+
+private:
+  static constexpr size_t kInitialSlots = 1024;
+
+  struct Slot {
+    uint32_t gen = 0;
+    Word word{0, 0, 0};
+  };
+
+  static uint64_t mix(uint64_t x) {  // splitmix64 finaliser
+    x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27; x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+  }
+
+  static uint64_t hash(const Word& w) {
+    return mix(((uint64_t)w.addr << 32 | w.data) ^ ((uint64_t)w.mask << 60) ^ 0x9e3779b97f4a7c15ull);
+  }
+
+  size_t index(uint32_t addr) const {
+    return (size_t)(mix(addr) & (slots_.size() - 1));
+  }
+
+  Slot& find(uint32_t addr) {
+    for (size_t i = index(addr);; i = (i + 1) & (slots_.size() - 1)) {
+      Slot& s = slots_[i];
+      if (s.gen != gen_ || s.word.addr == addr) return s;
+    }
+  }
+
+  void grow() {
+    std::vector<Slot> old;
+    old.swap(slots_);
+    slots_.assign(old.size() * 2, Slot());
+    const uint32_t gen = gen_;
+    gen_ = 1;
+    for (const Slot& s : old) {
+      if (s.gen == gen) find(s.word.addr) = Slot{1, s.word};
+    }
+  }
+
+  std::vector<Slot> slots_;
+  uint32_t gen_ = 1;
+  size_t used_ = 0;
+  uint64_t digest_ = 0;
+};
@@ -0,0 +1,64 @@
+/**
+ * @file MemoryLayout.hpp
+ * @brief Memory map shared by the DUT and every golden backend
+ *
+ * The DUT, the built-in ISS and the Spike ELF builder
+ * must place an input at the same address, or switching GOLDEN_MODE changes
+ * the verdict. They all read the map through MemoryLayout::from_env(). Unset
+ * variables fall back to tools/memory_config.mk, which is also what the RTL
+ * parameters (-GPROGADDR_RESET, -GSTACKADDR) are built from, so a harness
+ * started outside run.sh still fetches from where the input is.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * @brief Numeric environment variable (hex with 0x, or decimal), or @p fallback
+ */
+inline uint32_t env_addr(const char* name, uint32_t fallback) {
+  const char* v = std::getenv(name);
+  return (v && *v) ? (uint32_t)std::strtoul(v, nullptr, 0) : fallback;
+}
+
+/**
+ * @struct MemoryLayout
+ * @brief Reset vector, RAM and stack as exported by run.sh
+ *
+ * Example usage:
+ * @code
+ *   const MemoryLayout layout = MemoryLayout::from_env();
+ *   mem.reserve(layout.reset_vector, (uint32_t)layout.image_size());
+ *   mem.load(layout.reset_vector, input.data(), input.size());
+ * @endcode
+ */
+struct MemoryLayout {
+  // Defaults: tools/memory_config.mk
+  static constexpr uint32_t kResetVector = 0x80000000u;  ///< PROGADDR_RESET
+  static constexpr uint32_t kRamBase     = 0x80040000u;  ///< RAM_BASE
+  static constexpr uint32_t kRamSize     = 0x00040000u;  ///< RAM_SIZE_ALIGNED
+  static constexpr uint32_t kStackAddr   = 0x8007FFF0u;  ///< STACK_ADDR
+
+  uint32_t reset_vector = kResetVector;  ///< Input load address and first fetch
+  uint32_t ram_base = kRamBase;
+  uint32_t ram_size = kRamSize;
+  uint32_t stack_addr = kStackAddr;      ///< Initial x2, as the RTL STACKADDR parameter
+
+  /// @brief Read PROGADDR_RESET, RAM_BASE, RAM_SIZE and STACKADDR
+  static MemoryLayout from_env() {
+    MemoryLayout l;
+    l.reset_vector = env_addr("PROGADDR_RESET", kResetVector);
+    l.ram_base = env_addr("RAM_BASE", kRamBase);
+    l.ram_size = env_addr("RAM_SIZE", kRamSize);
+    l.stack_addr = env_addr("STACKADDR", kStackAddr);
+    return l;
+  }
+
+  /// @brief Bytes from the reset vector to the end of RAM (largest program image)
+  size_t image_size() const {
+    return ram_base >= reset_vector ? (size_t)(ram_base - reset_vector) + ram_size : ram_size;
+  }
+};
@@ -0,0 +1,223 @@
+/**
+ * @file MemoryMap.hpp
+ * @brief Page-granular bus dispatch for the DUT: RAM plus MMIO devices
+ *
+ * Every 4 KiB page of the 32-bit address space maps either to RAM (the
+ * default, backed by PagedMemory) or to one registered BusDevice. The lookup
+ * is a single byte-table index, so adding devices does not slow down plain
+ * RAM accesses. Devices can raise bus events (such as "program exited") at
+ * the moment the access happens instead of being polled per commit.
+ */
+
+#pragma once
+
+#include "PagedMemory.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Events raised by devices during bus accesses
+ *
+ * Cleared by MemoryMap::reset(); the CPU model checks them after each cycle.
+ */
+struct BusEvents {
+  bool exit = false;        ///< A device requested program termination
+  uint32_t exit_code = 0;   ///< Value written by the program (e.g. tohost)
+};
+
+/**
+ * @class BusDevice
+ * @brief Base class for memory-mapped devices on the DUT bus
+ *
+ * Accesses are aligned 32-bit words with byte strobes, exactly as they
+ * appear on the PicoRV32 native memory interface.
+ */
+class BusDevice {
+public:
+  virtual ~BusDevice() = default;
+
+  /// Aligned 32-bit read; bits [1:0] of @p addr are ignored.
+  virtual uint32_t read32(uint32_t addr) = 0;
+
+  /// Aligned 32-bit write with byte strobes (bit i enables byte i).
+  virtual void write32(uint32_t addr, uint32_t data, uint8_t wstrb) = 0;
+
+  /// Return to the power-on state (called on every DUT reset).
+  virtual void reset() {}
+};
+
+/**
+ * @class MemoryMap
+ * @brief RAM plus devices, dispatched through a per-page table
+ *
+ * Example usage:
+ * @code
+ *   MemoryMap bus;
+ *   bus.add_device(tohost_addr, PagedMemory::kPageSize,
+ *                  std::make_unique<ToHostDevice>(bus.ram(), bus.events(), tohost_addr));
+ *   bus.write32(tohost_addr, 1, 0xF);
+ *   if (bus.events().exit) { ... }
+ * @endcode
+ */
+class MemoryMap {
+public:
+  MemoryMap() : page_dev_(size_t(1) << (32 - PagedMemory::kPageBits), 0) {}
+
+  MemoryMap(const MemoryMap&) = delete;
+  MemoryMap& operator=(const MemoryMap&) = delete;
+
+  /**
+   * @brief Map @p dev over [base, base + size), rounded out to whole pages
+   * @return false if the table is full (255 devices) or @p size is zero
+   */
+  bool add_device(uint32_t base, uint32_t size, std::unique_ptr<BusDevice> dev) {
+    if (size == 0 || devices_.size() >= 255) return false;
+    devices_.push_back(std::move(dev));
+    const uint8_t id = (uint8_t)devices_.size();
+    uint64_t first = base >> PagedMemory::kPageBits;
+    uint64_t last = ((uint64_t)base + size - 1) >> PagedMemory::kPageBits;
+    for (uint64_t p = first; p <= last && p < page_dev_.size(); ++p) {
+      page_dev_[(size_t)p] = id;
+    }
+    return true;
+  }
+
+  uint32_t read32(uint32_t addr) {
+    uint8_t id = page_dev_[addr >> PagedMemory::kPageBits];
+    return id ? devices_[id - 1]->read32(addr) : ram_.read32(addr);
+  }
+
+  void write32(uint32_t addr, uint32_t data, uint8_t wstrb) {
+    uint8_t id = page_dev_[addr >> PagedMemory::kPageBits];
+    if (id) devices_[id - 1]->write32(addr, data, wstrb);
+    else    ram_.write32(addr, data, wstrb);
+  }
+
+  /// Clears RAM (dirty pages only), device state and pending events.
+  void reset() {
+    ram_.reset();
+    for (auto& d : devices_) d->reset();
+    events_ = BusEvents();
+  }
+
+  PagedMemory& ram() { return ram_; }
+  BusEvents& events() { return events_; }
+  const BusEvents& events() const { return events_; }
+
+private:
+  PagedMemory ram_;
+  std::vector<uint8_t> page_dev_;                    // 0 = RAM, n = devices_[n-1]
+  std::vector<std::unique_ptr<BusDevice>> devices_;
+  BusEvents events_;
+};
+
+// ============================================================================
+// Devices
+// ============================================================================
+
+/**
+ * @class ToHostDevice
+ * @brief RISC-V test "tohost" mailbox: any store to it ends the program
+ *
+ * Occupies a whole page but only the tohost word is special; every other
+ * offset (and the tohost word itself) is still backed by RAM, so the page
+ * looks like ordinary memory to the program and to memory comparisons.
+ */
+class ToHostDevice final : public BusDevice {
+public:
+  ToHostDevice(PagedMemory& ram, BusEvents& events, uint32_t tohost_addr)
+    : ram_(ram), events_(events), tohost_word_(tohost_addr & ~0x3u) {}
+
+  uint32_t read32(uint32_t addr) override { return ram_.read32(addr); }
+
+  void write32(uint32_t addr, uint32_t data, uint8_t wstrb) override {
+    ram_.write32(addr, data, wstrb);
+    if ((addr & ~0x3u) == tohost_word_ && (wstrb & 0xF)) {
+      events_.exit = true;
+      events_.exit_code = data;
+    }
+  }
+
+private:
+  PagedMemory& ram_;
+  BusEvents& events_;
+  uint32_t tohost_word_;
+};
+
+/**
+ * @class UartDevice
+ * @brief Minimal transmit-only UART stand-in
+ *
+ * Register map (offsets from the device base):
+ * - 0x0 TX data: low byte of each write is appended to output()
+ * - 0x4 status: always reads 0 (transmitter ready)
+ *
+ * Output is capped so a program spinning on the UART cannot grow it
+ * without bound.
+ */
+class UartDevice final : public BusDevice {
+public:
+  static constexpr size_t kMaxOutput = 4096;
+
+  explicit UartDevice(uint32_t base) : base_(base) {}
+
+  uint32_t read32(uint32_t) override { return 0; }
+
+  void write32(uint32_t addr, uint32_t data, uint8_t wstrb) override {
+    if (((addr - base_) & ~0x3u) == 0 && (wstrb & 1) && out_.size() < kMaxOutput) {
+      out_.push_back((char)(data & 0xFF));
+    }
+  }
+
+  void reset() override { out_.clear(); }
+
+  const std::string& output() const { return out_; }
+
+private:
+  uint32_t base_;
+  std::string out_;
+};
+
+/**
+ * @class TimerDevice
+ * @brief CLINT-style mtime/mtimecmp stand-in driven by the DUT cycle count
+ *
+ * Register map (offsets from the device base):
+ * - 0x0 / 0x4 mtime low / high (read-only, = simulated cycles)
+ * - 0x8 / 0xC mtimecmp low / high (read/write, no interrupt is raised)
+ */
+class TimerDevice final : public BusDevice {
+public:
+  TimerDevice(uint32_t base, const uint64_t& cycles) : base_(base), cycles_(cycles) {}
+
+  uint32_t read32(uint32_t addr) override {
+    switch ((addr - base_) & 0xCu) {
+      case 0x0: return (uint32_t)cycles_;
+      case 0x4: return (uint32_t)(cycles_ >> 32);
+      case 0x8: return (uint32_t)mtimecmp_;
+      default:  return (uint32_t)(mtimecmp_ >> 32);
+    }
+  }
+
+  void write32(uint32_t addr, uint32_t data, uint8_t wstrb) override {
+    uint32_t off = (addr - base_) & 0xCu;
+    if (off < 0x8) return;  // mtime is read-only here
+    unsigned shift = (off == 0x8) ? 0 : 32;
+    for (unsigned i = 0; i < 4; ++i) {
+      if (wstrb & (1u << i)) {
+        uint64_t m = (uint64_t)0xFF << (shift + 8 * i);
+        mtimecmp_ = (mtimecmp_ & ~m) | ((uint64_t)((data >> (8 * i)) & 0xFF) << (shift + 8 * i));
+      }
+    }
+  }
+
+  void reset() override { mtimecmp_ = ~(uint64_t)0; }
+
+private:
+  uint32_t base_;
+  const uint64_t& cycles_;
+  uint64_t mtimecmp_ = ~(uint64_t)0;
+};
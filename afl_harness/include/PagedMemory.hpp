@@ -0,0 +1,152 @@
+/**
+ * @file PagedMemory.hpp
+ * @brief Sparse, paged DUT memory with dirty-page tracking
+ *
+ * Backs the simulated CPU's memory bus with 4 KiB pages that are allocated
+ * on first write. The full 32-bit physical address space is addressable
+ * without reserving it up front, and reset() only clears the pages the
+ * previous run actually wrote.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+/**
+ * @class PagedMemory
+ * @brief Two-level page table over a 32-bit address space
+ *
+ * Address split: [31:22] directory index, [21:12] table index, [11:0] offset.
+ * A directory entry (1024 page pointers) is created the first time any page
+ * below it is written. Reads from untouched pages return zero and never
+ * allocate, so a wild load costs nothing.
+ *
+ * Every page written since the last reset() is kept on a dirty list;
+ * reset() zeroes exactly those pages. With a typical sub-2 KiB input and a
+ * small stack frame that is one or two pages instead of the whole RAM.
+ *
+ * @note Pages are never freed; they stay resident for the next input
+ * @note Not thread-safe; each CPU instance owns its own PagedMemory
+ *
+ * Example usage:
+ * @code
+ *   PagedMemory mem;
+ *   mem.reserve(RAM_BASE, RAM_SIZE);        // optional: size the page pool
+ *   mem.load(PROGADDR_RESET, input.data(), input.size());
+ *   uint32_t insn = mem.read32(PROGADDR_RESET);
+ *   mem.write32(STACK_ADDR, 0xdeadbeef, 0xF);
+ *   mem.reset();                             // clears only dirty pages
+ * @endcode
+ */
+class PagedMemory {
+public:
+  static constexpr unsigned kPageBits  = 12;
+  static constexpr uint32_t kPageSize  = 1u << kPageBits;
+  static constexpr unsigned kTableBits = 10;
+  static constexpr uint32_t kTableSize = 1u << kTableBits;
+
+  PagedMemory() : dir_(kTableSize) {}
+
+  PagedMemory(const PagedMemory&) = delete;
+  PagedMemory& operator=(const PagedMemory&) = delete;
+
+  /**
+   * @brief Pre-size the page pool for a region that is expected to be used
+   *
+   * Only reserves bookkeeping capacity so the first run does not reallocate
+   * the pool; pages themselves are still allocated on first write.
+   *
+   * @param base Start address of the region
+   * @param size Region size in bytes
+   */
+  void reserve(uint32_t base, uint32_t size) {
+    (void)base;
+    size_t pages = (static_cast<size_t>(size) + kPageSize - 1) / kPageSize;
+    pages_.reserve(pages_.size() + pages);
+    dirty_.reserve(dirty_.capacity() + pages);
+  }
+
+  /// Aligned 32-bit read; bits [1:0] of @p addr are ignored.
+  uint32_t read32(uint32_t addr) const {
+    const Page* p = find(addr);
+    if (!p) return 0;
+    uint32_t word;
+    std::memcpy(&word, p->bytes + (addr & (kPageSize - 1) & ~0x3u), sizeof(word));
+    return word;  // Little-endian host, same as the RISC-V bus
+  }
+
+  /// Aligned 32-bit write with byte strobes (bit i enables byte i).
+  void write32(uint32_t addr, uint32_t data, uint8_t wstrb) {
+    uint8_t* b = touch(addr)->bytes + (addr & (kPageSize - 1) & ~0x3u);
+    if (wstrb & 1) b[0] = (uint8_t)(data & 0xFF);
+    if (wstrb & 2) b[1] = (uint8_t)((data >> 8) & 0xFF);
+    if (wstrb & 4) b[2] = (uint8_t)((data >> 16) & 0xFF);
+    if (wstrb & 8) b[3] = (uint8_t)((data >> 24) & 0xFF);
+  }
+
+  /// Copy @p len bytes to @p addr, page by page. Wraps at 4 GiB.
+  void load(uint32_t addr, const unsigned char* data, size_t len) {
+    while (len > 0) {
+      uint32_t off = addr & (kPageSize - 1);
+      size_t n = kPageSize - off;
+      if (n > len) n = len;
+      std::memcpy(touch(addr)->bytes + off, data, n);
+      addr += static_cast<uint32_t>(n);
+      data += n;
+      len -= n;
+    }
+  }
+
+  /// Zero every page written since the previous reset().
+  void reset() {
+    for (Page* p : dirty_) {
+      std::memset(p->bytes, 0, kPageSize);
+      p->dirty = false;
+    }
+    dirty_.clear();
+  }
+
+  size_t resident_pages() const { return pages_.size(); }  ///< Pages ever allocated
+  size_t dirty_pages() const { return dirty_.size(); }     ///< Pages reset() will clear
+
+private:
+  struct Page {
+    uint8_t bytes[kPageSize];
+    bool dirty;
+  };
+  using Table = std::unique_ptr<Page*[]>;
+
+  static uint32_t dir_index(uint32_t addr) { return addr >> (kPageBits + kTableBits); }
+  static uint32_t table_index(uint32_t addr) { return (addr >> kPageBits) & (kTableSize - 1); }
+
+  const Page* find(uint32_t addr) const {
+    const Table& t = dir_[dir_index(addr)];
+    return t ? t[table_index(addr)] : nullptr;
+  }
+
+  // Returns the page for @p addr, allocating it and marking it dirty as needed
+  Page* touch(uint32_t addr) {
+    Table& t = dir_[dir_index(addr)];
+    if (!t) {
+      t.reset(new Page*[kTableSize]());
+    }
+    Page*& p = t[table_index(addr)];
+    if (!p) {
+      pages_.emplace_back(new Page());  // Value-initialised: zeroed, not dirty
+      p = pages_.back().get();
+    }
+    if (!p->dirty) {
+      p->dirty = true;
+      dirty_.push_back(p);
+    }
+    return p;
+  }
+
+  std::vector<Table> dir_;                    // 1024 directory entries
+  std::vector<std::unique_ptr<Page>> pages_;  // Owns every allocated page
+  std::vector<Page*> dirty_;                  // Pages written since reset()
+};
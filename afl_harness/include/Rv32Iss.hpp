@@ -0,0 +1,95 @@
+/**
+ * @file Rv32Iss.hpp
+ * @brief In-process RV32IM reference interpreter used as a golden model
+ *
+ * A small instruction-set simulator that executes the same program image as
+ * the DUT and emits one CommitRec per retired instruction, using the RVFI
+ * conventions the DUT trace uses (word-aligned mem_addr, lane masks, pc_r /
+ * pc_w). It replaces Spike for GOLDEN_MODE=builtin: no ELF build, no process
+ * and no log parsing, so it runs on machines without a RISC-V toolchain.
+ */
+
+#pragma once
+
+#include "PagedMemory.hpp"
+#include "Trace.hpp"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @class Rv32Iss
+ * @brief RV32IM interpreter matching the PicoRV32 configuration we fuzz
+ *
+ * Behaviour follows PicoRV32 with CATCH_MISALIGN/CATCH_ILLINSN and
+ * ENABLE_COUNTERS: misaligned loads, stores and jump targets, illegal
+ * instructions, ECALL and EBREAK all retire as a trap and halt the model.
+ * The only CSR accesses are the rdcycle/rdinstret(h) forms of CSRRS; the
+ * model retires one instruction per cycle, so cycle reads return instret.
+ * A store to the tohost word retires normally and then halts the model.
+ *
+ * Memory is a PagedMemory, so after the first input no step allocates.
+ *
+ * Example usage:
+ * @code
+ *   Rv32Iss iss;
+ *   iss.set_tohost(0x80001000);
+ *   iss.reset(0x80000000, 0x8007FFF0);
+ *   iss.load(0x80000000, input.data(), input.size());
+ *   CommitRec rec;
+ *   while (iss.step(rec)) { ... }
+ *   bool clean = iss.exited();   // tohost or ECALL, not a fault
+ * @endcode
+ *
+ * @note Not thread-safe; each GoldenModel owns its own instance
+ */
+class Rv32Iss {
+public:
+  Rv32Iss() = default;
+
+  Rv32Iss(const Rv32Iss&) = delete;
+  Rv32Iss& operator=(const Rv32Iss&) = delete;
+
+  /// Enable tohost exit detection for stores to @p addr (word granular).
+  void set_tohost(uint32_t addr) { tohost_word_ = addr & ~0x3u; use_tohost_ = true; }
+
+  /// Pre-size the page pool for the program/RAM region.
+  void reserve(uint32_t base, uint32_t size) { mem_.reserve(base, size); }
+
+  /**
+   * @brief Return to the power-on state
+   * @param pc Reset vector (PROGADDR_RESET)
+   * @param sp Initial x2, or 0xFFFFFFFF to leave it zero (PicoRV32 STACKADDR)
+   */
+  void reset(uint32_t pc, uint32_t sp);
+
+  /// Copy a program image into memory.
+  void load(uint32_t addr, const unsigned char* data, size_t len) { mem_.load(addr, data, len); }
+
+  /**
+   * @brief Execute one instruction
+   * @param rec Filled with the instruction's commit record
+   * @return False (and @p rec untouched) once the model has halted
+   */
+  bool step(CommitRec& rec);
+
+  bool halted() const { return halted_; }            ///< No further commits will be produced
+  bool exited() const { return halted_ && clean_; }  ///< Halted on tohost or ECALL
+  uint32_t exit_code() const { return exit_code_; }  ///< Value stored to tohost
+  uint64_t retired() const { return instret_; }      ///< Instructions retired, traps included
+  uint32_t pc() const { return pc_; }
+
+private:
+  void trap(CommitRec& rec, bool clean);
+
+  PagedMemory mem_;
+  uint32_t x_[32] = {};
+  uint32_t pc_ = 0;
+  uint64_t instret_ = 0;
+
+  bool use_tohost_ = false;
+  uint32_t tohost_word_ = 0;
+
+  bool halted_ = false;
+  bool clean_ = false;
+  uint32_t exit_code_ = 0;
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "InputView.hpp"
 #include <string>
 #include <vector>
 #include <cstdint>
@@ -12,11 +13,26 @@ namespace spike_helpers {
 void print_log_tail(const char* path, int max_lines = 50);
 
 /// @brief Build a temporary ELF file from raw binary input for Spike execution
+/// @note Runs objcopy + ld with LINKER_SCRIPT; only used with SPIKE_ELF_BUILDER=toolchain
 /// @param input Raw binary input data
-/// @param ram_base RAM base address for linking
-/// @param ram_size RAM size for linking
 /// @return Path to temporary ELF file, or empty string on failure
-std::string build_spike_elf(const std::vector<unsigned char>& input);
+std::string build_spike_elf(InputView input);
+
+/// @brief Create an anonymous, reusable file for ELF images (memfd, else /dev/shm)
+/// @param path Set to a /proc/<pid>/fd path that a child process such as Spike can open
+/// @return File descriptor, or -1 on failure
+int open_elf_image(std::string& path);
+
+/// @brief Write @p input as the ELF that objcopy + ld with tools/link.ld would produce
+/// @details One PT_LOAD segment holding the bytes, VMA @p ram_base and LMA
+///          @p load_addr (the .data >RAM AT>ROM placement), entry @p load_addr
+/// @param fd File from open_elf_image(); truncated and rewritten in place
+/// @param input Raw binary input data
+/// @param load_addr PROGADDR_RESET
+/// @param ram_base RAM_BASE
+/// @return True on success
+bool write_elf_image(int fd, InputView input,
+                     uint32_t load_addr, uint32_t ram_base);
 
 /// @brief Format a command line argument for safe display (escape spaces/quotes)
 /// @param arg Raw argument string
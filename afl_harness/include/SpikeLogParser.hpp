@@ -0,0 +1,180 @@
+/**
+ * @file SpikeLogParser.hpp
+ * @brief Allocation-free parser for Spike's commit log (`spike -l`)
+ *
+ * Replaces the std::getline + std::regex parsing that SpikeProcess used to do
+ * per retired instruction. Output is read into one large buffer and handed
+ * out as std::string_view lines; each line is matched by hand-written
+ * scanners and hex fields are decoded in place. Recognised patterns are the
+ * ones SpikeProcess always accepted:
+ *
+ *   core   0: 0x80000000 (0x00000013) ...        commit (pc, insn)
+ *   core   0: exception <cause>, epc 0x...       fatal trap
+ *   ... x5) := 0x0000002a                         register write
+ *   ... W x5 <- 0x0000002a  (also W0/W1, :, =, -) register write
+ *   ... mem [0x80001000] = 0x00000001  (<-, :)    store
+ *   ... mem [0x80001000] -> 0x00000001 (=>)       load
+ */
+
+#pragma once
+
+#include "Trace.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+#include <vector>
+
+namespace spike_log {
+
+/// @brief Match a commit line (`core 0: 0x<pc> (0x<insn>)` anywhere in the line)
+bool parse_commit(std::string_view line, uint32_t& pc, uint32_t& insn);
+
+/// @brief True for lines Spike prints when it takes an exception
+bool is_trap_line(std::string_view line);
+
+/// @brief Short "<cause> at epc=0x<epc>" summary of a trap line, or the line itself
+std::string trap_summary(std::string_view line);
+
+/// @brief Apply a register-write or memory-access line to @p rec
+/// @return True if the line matched one of the patterns
+bool parse_detail(std::string_view line, CommitRec& rec);
+
+} // namespace spike_log
+
+/**
+ * @class LineBuffer
+ * @brief Splits a byte stream into lines without copying
+ *
+ * Lines are returned without the trailing newline and stay valid until the
+ * next call to next(). A line longer than the buffer is returned in
+ * buffer-sized pieces.
+ */
+class LineBuffer {
+public:
+  /// read(2)-like source: bytes read, 0 at end of stream, -1 on error.
+  using Reader = std::function<ssize_t(char* buf, size_t n)>;
+
+  explicit LineBuffer(size_t capacity = 64 * 1024) : buf_(capacity) {}
+
+  /// Start reading from @p reader, discarding buffered data.
+  void reset(Reader reader);
+
+  /// Start reading from @p fd (not owned).
+  void reset(int fd);
+
+  /// @brief Next line, or false at end of file / read error
+  bool next(std::string_view& line);
+
+  /// Make the following next() return the current line again.
+  void unread() { replay_ = true; }
+
+private:
+  std::vector<char> buf_;
+  size_t begin_ = 0;
+  size_t end_ = 0;
+  Reader reader_;
+  std::string_view last_;
+  bool replay_ = false;
+  bool eof_ = false;
+};
+
+/**
+ * @class SpikeLogRing
+ * @brief In-memory flight recorder for the raw Spike log
+ *
+ * Keeps the raw lines of the last N instructions of a run, one chunk per
+ * instruction (the first chunk holds the preamble). Nothing reaches the disk
+ * until the owner calls dump(); chunk strings keep their capacity, so a
+ * steady-state run does not allocate.
+ *
+ * Example usage:
+ * @code
+ *   SpikeLogRing ring(256);          // 0 keeps the whole run
+ *   parser.reset(log_fd, &ring);
+ *   ...
+ *   std::string text;
+ *   ring.dump(text);                 // oldest to newest chunk
+ * @endcode
+ */
+class SpikeLogRing {
+public:
+  explicit SpikeLogRing(size_t chunks = 256) { set_capacity(chunks); }
+
+  /// Number of chunks kept; 0 keeps every chunk. Clears the ring.
+  void set_capacity(size_t chunks);
+
+  /// Drop all chunks and start the preamble chunk of a new run.
+  void clear();
+
+  /// Start the chunk of the next instruction.
+  void begin_chunk();
+
+  /// Append @p line plus a newline to the current chunk.
+  void append_line(std::string_view line);
+
+  /// Append raw text to the current chunk.
+  void append(std::string_view text) { current().append(text.data(), text.size()); }
+
+  /// @brief Append the kept chunks to @p out, oldest first
+  /// @note Evicted chunks are replaced by a one-line marker
+  void dump(std::string& out) const;
+
+  /// True when nothing was recorded since clear().
+  bool empty() const { return total_ == 1 && chunks_[0].empty(); }
+
+private:
+  std::string& current() { return chunks_[slot(total_ - 1)]; }
+  size_t slot(size_t n) const { return capacity_ ? n % capacity_ : n; }
+
+  std::vector<std::string> chunks_;
+  size_t capacity_ = 0;
+  size_t total_ = 0;   // Chunks started since clear(), preamble included
+};
+
+/**
+ * @class SpikeLogParser
+ * @brief Turns a Spike log stream into CommitRecs
+ *
+ * Each commit line starts a record; up to 16 following lines are scanned for
+ * register writes and memory accesses, stopping at the next commit line or
+ * a blank line. Lines can be mirrored to a SpikeLogRing, framed per
+ * instruction as the raw log always was.
+ *
+ * Example usage:
+ * @code
+ *   SpikeLogParser parser;
+ *   parser.reset(log_fd, &raw_log_ring);
+ *   CommitRec rec;
+ *   while (parser.next(rec) == SpikeLogParser::Event::Commit) { ... }
+ * @endcode
+ */
+class SpikeLogParser {
+public:
+  enum class Event { Commit, FatalTrap, End };
+
+  explicit SpikeLogParser(size_t buffer_size = 64 * 1024) : lines_(buffer_size) {}
+
+  /// Start parsing a new stream; @p raw_log may be null.
+  void reset(LineBuffer::Reader reader, SpikeLogRing* raw_log = nullptr);
+  void reset(int fd, SpikeLogRing* raw_log = nullptr);
+
+  /// @brief Parse until the next commit, fatal trap or end of stream
+  /// @param rec Filled on Event::Commit (pc_w, insn, rd_*, mem_*)
+  Event next(CommitRec& rec);
+
+  /// Summary of the trap behind the last Event::FatalTrap.
+  const std::string& trap_summary() const { return trap_summary_; }
+
+  size_t commits() const { return commits_; }
+
+private:
+  void log_line(std::string_view line);
+
+  LineBuffer lines_;
+  SpikeLogRing* raw_log_ = nullptr;
+  std::string trap_summary_;
+  size_t commits_ = 0;
+};
@@ -4,7 +4,7 @@
  * 
  * This file provides SpikeProcess, a robust interface to the Spike simulator that:
  * 1. Launches Spike as a subprocess with logging enabled
- * 2. Streams and archives Spike's textual output for debugging
+ * 2. Keeps the tail of Spike's textual output for post-mortem logs
  * 3. Parses commit lines to extract instruction-level execution traces
  * 4. Detects and reports fatal traps and exceptions
  * 
@@ -14,13 +14,12 @@
 
 #pragma once
 
+#include "SpikeLogParser.hpp"
+#include "Subprocess.hpp"
 #include "Trace.hpp"
-#include <boost/process.hpp>
 #include <cstdio>
-#include <memory>
-#include <optional>
-#include <regex>
 #include <string>
+#include <sys/wait.h>
 
 /**
  * @class SpikeProcess
@@ -32,7 +31,8 @@
  * 
  * Key features:
  * - **Process management**: Spawns, monitors, and terminates Spike subprocess
- * - **Log archival**: Streams raw output to file for post-mortem analysis
+ * - **Log flight recorder**: Keeps the last N instructions of raw output in
+ *   memory and writes them out on request (crash, divergence, sampled run)
  * - **Commit parsing**: Extracts PC, instruction, register writes, memory ops
  * - **Trap detection**: Identifies fatal exceptions in Spike's output
  * - **Best-effort parsing**: Handles variations in Spike log format gracefully
@@ -41,9 +41,10 @@
  * @code
  *   [SpikeProcess] ──spawn──> [spike -l --isa=rv32im test.elf]
  *          │                           │
- *          │◄──────stdout/stderr───────┘
+ *          │◄──stderr (commit log)─────┤
+ *          │◄──stdout (console, kept)──┘
  *          │
- *          ├──> [spike.log file]   (raw archive)
+ *          ├──> [SpikeLogRing]     (last N raw chunks ──dump_log()──> spike.log)
  *          └──> [CommitRec stream] (parsed commits)
  * @endcode
  * 
@@ -94,44 +95,117 @@ public:
   SpikeProcess() = default;
   
   /**
-   * @brief Destructor ensures cleanup of Spike process and log file
+   * @brief Destructor ensures cleanup of the Spike process
    * 
-   * Automatically calls stop() to wait for the Spike subprocess (if running)
-   * and close the log file. This ensures no zombie processes or file handle
-   * leaks even if stop() wasn't called explicitly.
+   * Automatically calls stop() to wait for the Spike subprocess (if running).
+   * This ensures no zombie processes even if stop() wasn't called explicitly.
    */
   ~SpikeProcess() { stop(); }
 
   /**
-   * @brief Configure where to archive Spike's raw output
+   * @brief Configure where dump_log() archives Spike's raw output
    * 
-   * Sets the path for the log file where Spike's complete textual output
-   * will be written. The file is opened in append mode (never truncates)
-   * and uses line-buffering for live updates during execution.
+   * With a log path set, every run records its raw output in an in-memory
+   * ring (see set_log_ring()). Nothing is written while Spike runs; the
+   * ring reaches the file only through dump_log() or a sampled run.
    * 
-   * If the log path is empty or not set, Spike's output is still processed
-   * but not archived to disk. This is useful for performance-critical
-   * scenarios where log I/O overhead must be minimized.
+   * If the log path is empty or not set, Spike's output is parsed but not
+   * recorded at all.
    * 
    * @param p Full path to log file (e.g., "workdir/logs/spike.log")
    * 
    * @note Must be called before start() to take effect
-   * @note File is opened in append mode, preserving previous content
-   * @note Line-buffered to ensure entries appear immediately
+   * @note The file is shared by all workers; dumps are appended with one
+   *       O_APPEND write each, so they never interleave
    * 
    * Example:
    * @code
    *   spike.set_log_path("/tmp/fuzzing/spike_20250111T143052.log");
    *   spike.start(...);
-   *   // All Spike output now appends to the specified file
+   *   // ... divergence found ...
+   *   spike.dump_log("divergence");
    * @endcode
    * 
    * @code
-   *   spike.set_log_path("");  // Disable file logging (parse only)
+   *   spike.set_log_path("");  // Disable the raw log (parse only)
    * @endcode
    */
   void set_log_path(const std::string& p) { log_path_ = p; }
 
+  /**
+   * @brief Size the raw-log flight recorder
+   *
+   * @param chunks Instructions kept per run (one chunk each, plus the
+   *               preamble); 0 keeps the whole run
+   * @param sample_every Also dump every Nth run, crash or not; 0 disables
+   *
+   * Example:
+   * @code
+   *   spike.set_log_ring(256, 1000);  // last 256 instructions, 1 run in 1000
+   * @endcode
+   */
+  void set_log_ring(size_t chunks, unsigned sample_every) {
+    log_ring_.set_capacity(chunks);
+    sample_every_ = sample_every;
+  }
+
+  /**
+   * @brief Append the recorded raw output of the last run to the log file
+   *
+   * Writes the kept chunks between markers naming @p reason, the process
+   * and the Spike command. Each run is written at most once, so a sampled
+   * run that later turns out to diverge is not logged twice.
+   *
+   * @param reason Short tag for the marker line (e.g. "divergence")
+   * @return True if anything was written
+   */
+  bool dump_log(const char* reason);
+
+  /**
+   * @brief Forget the recorded output of the last run
+   *
+   * For runs that never started Spike (e.g. a golden cache hit), so that a
+   * later dump_log() does not write a stale log.
+   */
+  void discard_log() { log_ring_.clear(); }
+
+  /**
+   * @brief Deadline for Spike to exit after its log ends
+   *
+   * Also bounds how long a killed Spike may stay unreaped before a later
+   * start() blocks on it.
+   *
+   * @param ms Milliseconds (default 100)
+   */
+  void set_kill_timeout(int ms) { kill_timeout_ms_ = ms; }
+
+  /**
+   * @brief Longest Spike may go without printing before the run is stopped
+   *
+   * A Spike that neither logs nor exits (e.g. parked in wfi) would
+   * otherwise block next_commit() until AFL++'s own timeout. On expiry the
+   * run ends like a budget stop: next_commit() returns false, Spike is
+   * killed and the run is not finished.
+   *
+   * @param ms Milliseconds; 0 waits forever
+   */
+  void set_stall_timeout(int ms) { proc_.set_read_timeout(ms); }
+
+  /**
+   * @brief True if the last run was ended with SIGKILL by stop()
+   *
+   * Killed runs are reaped asynchronously, so they have no status.
+   */
+  bool killed() const { return killed_; }
+
+  /**
+   * @brief Wake a next_commit() blocked on Spike's output from another thread
+   *
+   * The blocked call returns false and the run is stopped as if Spike had
+   * been stopped early. Used to cancel the asynchronous golden pipeline.
+   */
+  void interrupt() { proc_.interrupt(); }
+
   /**
    * @brief Get the exact shell command used to launch Spike
    * 
@@ -203,6 +277,17 @@ public:
    */
   const std::string& fatal_trap_summary() const { return fatal_trap_summary_; }
 
+  /**
+   * @brief Check if the commit log ended because Spike closed it
+   * 
+   * True once next_commit() has returned false at end of file. False after
+   * interrupt(), a stall timeout (set_stall_timeout()) or a read error: the
+   * harness cut the stream short, so it is not the program's full run.
+   * 
+   * @return true if the log reached end of file
+   */
+  bool reached_eof() const { return at_eof_; }
+
   /**
    * @brief Check if process status is available
    * 
@@ -367,8 +452,7 @@ public:
    * On success:
    * - Spike is running as a child process
    * - Output stream is connected for reading
-   * - Log file is opened (if configured)
-   * - Regular expressions are initialized for parsing
+   * - The raw-log ring is cleared (if a log path is configured)
    * 
    * On failure:
    * - No process is spawned
@@ -383,7 +467,8 @@ public:
    * @return true if Spike started successfully, false on error (check last_error())
    * 
    * @note Terminates any previously running Spike instance
-   * @note Stderr is redirected to stdout so all output appears in one stream
+   * @note The commit log is parsed from stderr, where `spike -l` writes it;
+   *       the tail of stdout is appended to the raw-log ring by stop()
    * @note The ELF file must exist and be readable
    * 
    * Example (bare metal):
@@ -410,16 +495,18 @@ public:
              const std::string& pk_bin = std::string());
 
   /**
-   * @brief Stop Spike and wait for it to exit
+   * @brief Stop Spike and reap it
    * 
-   * Waits for the Spike subprocess to terminate (if running), records its
-   * wait status, releases the output stream, and closes the log file.
+   * If Spike's log already ended, waits up to the kill timeout for it to
+   * exit (then kills it) and records its wait status. If Spike is still
+   * running (early stop, fatal trap), it is killed and reaped later without
+   * waiting. A sampled run (see set_log_ring()) is dumped to the log file.
    * After stop(), status methods (exited(), exit_code(), etc.) become valid.
    * 
    * If Spike is not running, this is a no-op. It's safe to call stop()
    * multiple times.
    * 
-   * @note Blocking call - waits for Spike to exit
+   * @note Never blocks longer than the kill timeout
    * @note Automatically called by destructor
    * 
    * Example:
@@ -449,15 +536,15 @@ public:
    * 2. Extract PC and instruction encoding from commit line
    * 3. Read a short window of subsequent lines for register/memory operations
    * 4. Populate CommitRec with all available information
-   * 5. Write grouped instruction chunk to log file (if configured)
+   * 5. Record the grouped instruction chunk in the raw-log ring (if configured)
    * 6. Check for fatal trap indicators
    * 
-   * Log file format:
-   * Each instruction is written as a grouped chunk enclosed by markers:
+   * Raw log format:
+   * Each instruction is kept as a grouped chunk enclosed by markers:
    * @code
-   *   ========== INSTRUCTION #42 [PC=0x80000010, INSN=0x00108093] ==========
+   *   ----- SPIKE INSTR #42 pc=0x80000010 insn=0x00108093 -----
    *   <raw Spike output lines for this instruction>
-   *   ========== END #42 ==========
+   *   ----- END SPIKE INSTR -----
    * @endcode
    * 
    * CommitRec fields populated:
@@ -511,14 +598,9 @@ private:
   std::string spike_cmd_;
   
   /**
-   * @brief Child process handle (boost::process)
+   * @brief Spike child process; its stderr is the parsed stream
    */
-  std::optional<boost::process::child> child_;
-  
-  /**
-   * @brief Merged stdout/stderr stream from Spike
-   */
-  std::unique_ptr<boost::process::ipstream> child_stream_;
+  Subprocess proc_;
   
   /**
    * @brief Path to raw log file (empty if logging disabled)
@@ -526,36 +608,44 @@ private:
   std::string log_path_;
   
   /**
-   * @brief FILE* handle for log file (nullptr if not logging)
+   * @brief Raw output of the current run, last N instructions only
    */
-  FILE* log_file_ = nullptr;
-  
+  SpikeLogRing log_ring_;
+
   /**
-   * @brief Flag indicating a fatal trap was detected in Spike's output
+   * @brief Dump every Nth run (0 = only on request)
    */
-  bool fatal_trap_seen_ = false;
-  
+  unsigned sample_every_ = 0;
+
   /**
-   * @brief Human-readable description of detected trap
+   * @brief Runs started, for sampling
    */
-  std::string fatal_trap_summary_;
+  unsigned long runs_ = 0;
+
+  /**
+   * @brief The current run is dumped at stop()
+   */
+  bool sampled_ = false;
+
+  /**
+   * @brief The current run was already written by dump_log()
+   */
+  bool dumped_ = false;
   
   /**
-   * @brief Regex to detect commit lines in Spike's log
-   * Format: "core   0: ... commit ..."
+   * @brief Flag indicating a fatal trap was detected in Spike's output
    */
-  std::regex commit_re_;
+  bool fatal_trap_seen_ = false;
   
   /**
-   * @brief Regex to detect register writes
-   * Format: "x1 0x00000001" or similar
+   * @brief Human-readable description of detected trap
    */
-  std::regex reg_write_re_;
+  std::string fatal_trap_summary_;
   
   /**
-   * @brief Simplified regex for register writes (fallback)
+   * @brief Buffered, allocation-free parser over the Spike log pipe
    */
-  std::regex simple_reg_re_;
+  SpikeLogParser parser_;
   
   /**
    * @brief Last observed wait status from the subprocess
@@ -566,19 +656,24 @@ private:
    * @brief Flag indicating status validity (true after stop())
    */
   bool status_valid_ = false;
-  
+
   /**
-   * @brief Description of start() failure (empty on success)
+   * @brief Spike's log reached end of file during this run
    */
-  std::string start_error_;
-  
+  bool at_eof_ = false;
+
   /**
-   * @brief Line buffered between calls when next commit already seen
+   * @brief stop() killed a still-running Spike (no status collected)
    */
-  std::string pending_line_;
+  bool killed_ = false;
+
+  /**
+   * @brief Exit/reap deadline in milliseconds (see set_kill_timeout())
+   */
+  int kill_timeout_ms_ = 100;
   
   /**
-   * @brief Monotonic instruction counter for log headers
+   * @brief Description of start() failure (empty on success)
    */
-  size_t instr_index_ = 0;
+  std::string start_error_;
 };
@@ -0,0 +1,78 @@
+/**
+ * @file SpscRing.hpp
+ * @brief Bounded lock-free single-producer/single-consumer queue
+ *
+ * Used by the asynchronous golden pipeline: the golden thread pushes parsed
+ * CommitRecs, the DUT thread pops them. Each side keeps a private copy of
+ * the other side's index and only reloads it when the ring looks full or
+ * empty, so in steady state a push or pop touches no shared cache line
+ * besides the slot itself and its own index.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @class SpscRing
+ * @brief Fixed-capacity FIFO for exactly one producer and one consumer thread
+ *
+ * Example usage:
+ * @code
+ *   SpscRing<CommitRec, 4096> ring;
+ *   // producer thread                // consumer thread
+ *   while (!ring.push(rec)) yield();  CommitRec r;
+ *                                     if (ring.pop(r)) { ... }
+ * @endcode
+ *
+ * @tparam T Trivially copyable element type
+ * @tparam N Capacity, a power of two
+ */
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+  /// @brief Append @p v; false if the ring is full (producer only)
+  bool push(const T& v) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_cache_ == N) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail - head_cache_ == N) return false;
+    }
+    slots_[tail & (N - 1)] = v;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// @brief Take the oldest element; false if the ring is empty (consumer only)
+  bool pop(T& v) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head == tail_cache_) return false;
+    }
+    v = slots_[head & (N - 1)];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// Drop all elements. Only while neither side is using the ring.
+  void clear() {
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+    head_cache_ = tail_cache_ = 0;
+  }
+
+private:
+  // Consumer-owned line
+  alignas(64) std::atomic<size_t> head_{0};
+  size_t tail_cache_ = 0;
+  // Producer-owned line
+  alignas(64) std::atomic<size_t> tail_{0};
+  size_t head_cache_ = 0;
+
+  alignas(64) std::array<T, N> slots_;
+};
@@ -0,0 +1,153 @@
+/**
+ * @file Subprocess.hpp
+ * @brief posix_spawn-based child process with raw, non-blocking pipes
+ *
+ * Spike used to run through boost::process, which merged stdout and stderr
+ * into one iostream and hid a blocking wait() in teardown. Subprocess keeps
+ * the two streams apart on enlarged non-blocking pipes: one "primary" stream
+ * is read in large chunks by the caller, the other is drained into a small
+ * ring buffer whenever the caller waits in poll(). Teardown closes the pipes, gives the child a
+ * bounded time to exit and then kills it, or kills it right away and leaves
+ * the reaping to later calls (kill_async()).
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+/**
+ * @class ByteRing
+ * @brief Fixed-size buffer that keeps the most recent bytes appended to it
+ */
+class ByteRing {
+public:
+  explicit ByteRing(size_t capacity = 16 * 1024) : buf_(capacity) {}
+
+  void clear() { head_ = size_ = 0; }
+  void append(const char* data, size_t n);
+  size_t size() const { return size_; }
+  size_t capacity() const { return buf_.size(); }
+
+  /// Contents, oldest byte first.
+  std::string str() const;
+
+private:
+  std::vector<char> buf_;
+  size_t head_ = 0;   // Next write position
+  size_t size_ = 0;
+};
+
+/**
+ * @class Subprocess
+ * @brief One child process with separate stdout/stderr pipes
+ *
+ * Example usage:
+ * @code
+ *   Subprocess proc;
+ *   Subprocess::Options opt;
+ *   opt.primary = Subprocess::Stream::Err;      // Spike logs to stderr
+ *   if (!proc.spawn({"spike", "-l", "prog.elf"}, opt)) { ... proc.error() ... }
+ *   char buf[65536];
+ *   ssize_t n;
+ *   while ((n = proc.read(buf, sizeof(buf))) > 0) { ... }
+ *   proc.finish(100);                           // close pipes, reap or kill
+ *   std::string console = proc.captured().str();  // stdout tail
+ * @endcode
+ *
+ * @note Children start with default SIGPIPE handling and an empty signal
+ *       mask, even though the harness ignores SIGPIPE
+ */
+class Subprocess {
+public:
+  enum class Stream { Out, Err };
+
+  struct Options {
+    bool pipe_stdin = false;              ///< Give the caller a stdin pipe (else /dev/null)
+    Stream primary = Stream::Out;         ///< Stream returned by read()
+    size_t pipe_size = 1 << 20;           ///< F_SETPIPE_SZ request for both pipes
+    size_t capture_size = 16 * 1024;      ///< Ring size for the other stream
+  };
+
+  Subprocess();
+  ~Subprocess();
+
+  Subprocess(const Subprocess&) = delete;
+  Subprocess& operator=(const Subprocess&) = delete;
+
+  /// @brief Start argv[0] (searched in PATH) with argv as its arguments
+  /// @return False on failure; see error()
+  bool spawn(const std::vector<std::string>& argv, const Options& opt);
+  bool spawn(const std::vector<std::string>& argv) { return spawn(argv, Options()); }
+
+  bool running() const { return pid_ > 0; }
+  pid_t pid() const { return pid_; }
+
+  /// @brief Block until the primary stream has data, then read up to @p n bytes
+  /// @return Bytes read, 0 at end of stream, -1 on error, interrupt() or
+  ///         when set_read_timeout() expires (timed_out() is then true)
+  ssize_t read(char* buf, size_t n);
+
+  /// @brief Longest a read() may wait for data; 0 (default) waits forever
+  void set_read_timeout(int ms) { read_timeout_ms_ = ms; }
+
+  /// True if a read() of the current child gave up on set_read_timeout().
+  bool timed_out() const { return timed_out_; }
+
+  /// True once read() has seen the end of the primary stream.
+  bool eof() const { return eof_; }
+
+  /// @brief Make a read() blocked in another thread return -1
+  /// @note The only member that may be called concurrently with the others;
+  ///       a wake-up sent before spawn() is discarded by it
+  void interrupt();
+
+  /// @brief Write all of @p n bytes to the child's stdin
+  /// @return False if stdin is not piped or the child closed it
+  bool write_all(const void* data, size_t n);
+
+  /// Close the stdin pipe; the child sees end of file.
+  void close_stdin();
+
+  /// @brief Close all pipes and reap the child
+  /// @param timeout_ms Time the child gets to exit before SIGKILL
+  /// @return True if it exited on its own
+  bool finish(int timeout_ms);
+
+  /// SIGKILL the child (if running) and reap it.
+  void terminate();
+
+  /// @brief SIGKILL the child and return without waiting for it
+  /// @param deadline_ms Time after which a later spawn()/kill_async() blocks
+  ///        to reap it, so killed children never pile up as zombies
+  /// @note A status is recorded only if the child was already gone
+  void kill_async(int deadline_ms);
+
+  bool has_status() const { return status_valid_; }
+  int status() const { return status_; }   ///< Raw waitpid() status
+
+  /// Tail of the non-primary stream.
+  const ByteRing& captured() const { return captured_; }
+
+  const std::string& error() const { return error_; }
+
+private:
+  void drain_capture();
+  void close_fds();
+  bool reap(int options);
+
+  pid_t pid_ = -1;
+  int stdin_fd_ = -1;
+  int primary_fd_ = -1;
+  int capture_fd_ = -1;
+  int wake_fd_ = -1;        // eventfd for interrupt(), lives as long as the object
+  bool eof_ = false;
+  int read_timeout_ms_ = 0;
+  bool timed_out_ = false;
+  ByteRing captured_;
+  int status_ = 0;
+  bool status_valid_ = false;
+  std::string error_;
+};
@@ -3,9 +3,10 @@
  * @brief Instruction-level trace recording for differential testing
  * 
  * This file provides facilities for recording per-instruction commit records
- * during CPU execution. Traces are written in CSV format for easy analysis,
- * comparison, and post-mortem debugging. Both DUT and golden model traces
- * use the same CommitRec format for straightforward differential analysis.
+ * during CPU execution. Traces are written as fixed-size binary records
+ * (trace_format) through a user-space buffer; `afl/trace_convert --csv`
+ * turns them into CSV for reading. Both DUT and golden model traces use the
+ * same CommitRec format for straightforward differential analysis.
  */
 
 #pragma once
@@ -13,6 +14,7 @@
 #include "Utils.hpp"
 
 #include <string>
+#include <vector>
 #include <cstdint>
 #include <unistd.h>
 #include <fcntl.h>
@@ -146,9 +148,8 @@ struct CommitRec {
 	// ========================================================================
 	// Optional Extended Fields
 	// ========================================================================
-	// These fields provide additional detail but are not currently written
-	// to CSV traces. They can be used for internal bookkeeping and enhanced
-	// debugging when needed.
+	// These fields provide additional detail. Binary traces keep them; the
+	// CSV format does not.
 	
 	/**
 	 * @brief Data written to memory (if store occurred)
@@ -156,7 +157,7 @@ struct CommitRec {
 	 * The actual data value that was written to memory. Only valid when
 	 * mem_wmask is non-zero.
 	 * 
-	 * @note Not currently emitted in CSV output
+	 * @note Binary traces only; not emitted in CSV output
 	 */
 	uint32_t mem_wdata = 0;
 	
@@ -166,7 +167,7 @@ struct CommitRec {
 	 * The actual data value that was read from memory. Only valid when
 	 * mem_rmask is non-zero.
 	 * 
-	 * @note Not currently emitted in CSV output
+	 * @note Binary traces only; not emitted in CSV output
 	 */
 	uint32_t mem_rdata = 0;
 	
@@ -175,7 +176,7 @@ struct CommitRec {
 	 * 
 	 * Set to 1 if the instruction performed a memory read (LB, LH, LW, etc.).
 	 * 
-	 * @note Not currently emitted in CSV output
+	 * @note Binary traces only; not emitted in CSV output
 	 */
 	uint8_t  mem_is_load  = 0;
 	
@@ -184,25 +185,125 @@ struct CommitRec {
 	 * 
 	 * Set to 1 if the instruction performed a memory write (SB, SH, SW, etc.).
 	 * 
-	 * @note Not currently emitted in CSV output
+	 * @note Binary traces only; not emitted in CSV output
 	 */
 	uint8_t  mem_is_store = 0;
+
+	/**
+	 * @brief RVFI mcycle / minstret CSR updates for this commit
+	 * 
+	 * Write masks and new values as reported by the DUT's RVFI CSR ports,
+	 * so checkers can track counters without querying the CPU again.
+	 * All zero when the DUT does not expose CSR tracking.
+	 * 
+	 * @note Binary traces only; not emitted in CSV output
+	 */
+	uint64_t csr_mcycle_wmask   = 0;
+	uint64_t csr_mcycle_wdata   = 0;
+	uint64_t csr_minstret_wmask = 0;
+	uint64_t csr_minstret_wdata = 0;
 };
 
+/**
+ * @namespace trace_format
+ * @brief Binary trace file layout: versioned header + fixed-size records
+ * 
+ * Unlike the CSV trace, a binary trace keeps every CommitRec field
+ * (memory data, load/store flags, CSR updates). Records are packed
+ * little-endian without padding, so files compare byte for byte.
+ * 
+ * Layout:
+ * @code
+ *   Header (24 bytes): "HWTRACE\0", version, record_bytes, flags, reserved
+ *   Record (78 bytes): pc_r pc_w insn rd_addr rd_wdata mem_addr mem_rmask
+ *                      mem_wmask trap mem_wdata mem_rdata   (u32 each)
+ *                      mem_is_load mem_is_store             (u8 each)
+ *                      csr_mcycle_wmask csr_mcycle_wdata
+ *                      csr_minstret_wmask csr_minstret_wdata (u64 each)
+ * @endcode
+ */
+namespace trace_format {
+	constexpr char     kMagic[8]    = {'H', 'W', 'T', 'R', 'A', 'C', 'E', '\0'};
+	constexpr uint32_t kVersion     = 1;
+	constexpr size_t   kRecordBytes = 11 * 4 + 2 + 4 * 8;
+
+	/// Header flags
+	enum : uint32_t {
+		kFlagFinished = 1u << 0,  ///< Run ended cleanly (GoldenModel::finished())
+	};
+
+	struct Header {
+		char     magic[8];
+		uint32_t version;
+		uint32_t record_bytes;
+		uint32_t flags;
+		uint32_t reserved;
+	};
+	static_assert(sizeof(Header) == 24, "trace header must stay 24 bytes");
+
+	/// @brief Header for a new file
+	inline Header make_header(uint32_t flags) {
+		Header h{};
+		std::memcpy(h.magic, kMagic, sizeof(kMagic));
+		h.version = kVersion;
+		h.record_bytes = (uint32_t)kRecordBytes;
+		h.flags = flags;
+		return h;
+	}
+
+	/// @brief True if @p h starts a binary trace this build can read
+	inline bool valid_header(const Header& h) {
+		return std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 &&
+		       h.version == kVersion && h.record_bytes == kRecordBytes;
+	}
+
+	/// @brief Serialize @p r into kRecordBytes bytes at @p out
+	inline void pack(const CommitRec& r, uint8_t* out) {
+		const uint32_t w[11] = {r.pc_r, r.pc_w, r.insn, r.rd_addr, r.rd_wdata, r.mem_addr,
+		                        r.mem_rmask, r.mem_wmask, r.trap, r.mem_wdata, r.mem_rdata};
+		const uint64_t d[4] = {r.csr_mcycle_wmask, r.csr_mcycle_wdata,
+		                       r.csr_minstret_wmask, r.csr_minstret_wdata};
+		std::memcpy(out, w, sizeof(w));
+		out[44] = r.mem_is_load;
+		out[45] = r.mem_is_store;
+		std::memcpy(out + 46, d, sizeof(d));
+	}
+
+	/// @brief Inverse of pack()
+	inline void unpack(const uint8_t* in, CommitRec& r) {
+		uint32_t w[11];
+		uint64_t d[4];
+		std::memcpy(w, in, sizeof(w));
+		std::memcpy(d, in + 46, sizeof(d));
+		r.pc_r = w[0];      r.pc_w = w[1];      r.insn = w[2];
+		r.rd_addr = w[3];   r.rd_wdata = w[4];  r.mem_addr = w[5];
+		r.mem_rmask = w[6]; r.mem_wmask = w[7]; r.trap = w[8];
+		r.mem_wdata = w[9]; r.mem_rdata = w[10];
+		r.mem_is_load = in[44];
+		r.mem_is_store = in[45];
+		r.csr_mcycle_wmask = d[0];   r.csr_mcycle_wdata = d[1];
+		r.csr_minstret_wmask = d[2]; r.csr_minstret_wdata = d[3];
+	}
+}
+
 /**
  * @class TraceWriter
- * @brief CSV trace file writer for instruction commit records
+ * @brief Buffered trace file writer for instruction commit records
+ * 
+ * TraceWriter records one entry per committed instruction. By default the
+ * file is a binary trace (trace_format): a 24-byte header followed by one
+ * packed 78-byte record per commit, every CommitRec field included. Records
+ * are collected in a 1 MiB buffer and written with one write() per buffer,
+ * not one per commit; call flush() at the end of each run.
  * 
- * TraceWriter provides a simple interface for recording instruction-level
- * traces to CSV files. Each commit record is written as a single CSV line
- * with fields for PC, instruction encoding, register writes, and memory
- * operations.
+ * Format::Csv writes the human-readable CSV instead, through the same
+ * buffer. `afl/trace_convert --csv dut.trace dut.csv` produces it from a
+ * binary trace, and TraceFile reads either format.
  * 
- * The CSV format is designed for:
- * - Easy parsing by analysis scripts (Python, awk, etc.)
- * - Human readability for quick inspection
- * - Differential comparison between DUT and golden model traces
- * - Post-mortem debugging of divergences
+ * With set_ring() (TRACE_MODE=ring) the writer is a flight recorder instead:
+ * write() keeps the last N records in memory, open() and flush() touch no
+ * file, and dump_ring() writes the records out once a run turns out to be
+ * a finding.
  * 
  * CSV columns (in order):
  * 1. pc_r: Fetch PC (hex)
@@ -229,16 +330,17 @@ struct CommitRec {
  *   TraceWriter golden_trace;
  *   golden_trace.open_with_basename("workdir/traces", "golden.trace");
  *   
- *   while (cpu->rvfi_valid()) {
- *     CommitRec rec;
- *     rec.pc_r = cpu->rvfi_pc_rdata();
- *     rec.insn = cpu->rvfi_insn();
+ *   while (cpu->run_until_commit(rec, budget, n) == CommitStatus::Commit) {
  *     dut_trace.write(rec);
  *   }
+ *   dut_trace.flush();
  * @endcode
  */
 class TraceWriter {
 public:
+	/// @brief On-disk layout written by TraceWriter
+	enum class Format { Binary, Csv };
+
 	/**
 	 * @brief Default constructor (no file opened)
 	 * 
@@ -262,15 +364,44 @@ public:
 	explicit TraceWriter(const std::string& dir) { open(dir); }
 	
 	/**
-	 * @brief Destructor closes file descriptor if open
+	 * @brief Destructor writes buffered records and closes the file
+	 */
+	~TraceWriter() { close(); }
+
+	TraceWriter(const TraceWriter&) = delete;
+	TraceWriter& operator=(const TraceWriter&) = delete;
+
+	/**
+	 * @brief Select the file format for the next open()
+	 * @param format Format::Binary (default) or Format::Csv
 	 */
-	~TraceWriter() { if (fd_ >= 0) ::close(fd_); }
+	void set_format(Format format) { format_ = format; }
+
+	/**
+	 * @brief Keep only the last @p records commits in memory (0 = write files)
+	 * 
+	 * Example:
+	 * @code
+	 *   tracer.set_ring(1024);
+	 *   ...                                    // run; nothing reaches the disk
+	 *   tracer.dump_ring(crash_base + ".dut.trace");
+	 * @endcode
+	 */
+	void set_ring(size_t records) {
+		close();
+		ring_.assign(records, CommitRec());
+		ring_next_ = ring_count_ = 0;
+	}
+
+	/// @brief True in flight-recorder mode (set_ring() with a non-zero size)
+	bool ring() const { return !ring_.empty(); }
 
 	/**
 	 * @brief Open trace file with default name "dut.trace"
 	 * 
 	 * Creates the directory if it doesn't exist, then opens/creates the
-	 * trace file with CSV header. Any existing file is truncated.
+	 * trace file and starts it with the format header. Any existing file
+	 * is truncated.
 	 * 
 	 * @param dir Directory path for trace file
 	 * @return true if file opened successfully, false on error
@@ -292,7 +423,8 @@ public:
 	 * 
 	 * Allows specifying a custom filename (e.g., "golden.trace", "ref.trace")
 	 * instead of the default "dut.trace". Useful for creating separate traces
-	 * for DUT and golden model.
+	 * for DUT and golden model. Reopening the file that is already open (once
+	 * per input) truncates it in place instead of opening it again.
 	 * 
 	 * @param dir Directory path for trace file
 	 * @param base Filename to create in the directory
@@ -306,23 +438,35 @@ public:
 	 * @endcode
 	 */
 	bool open_with_basename(const std::string& dir, const std::string& base) {
-		if (fd_ >= 0) { ::close(fd_); fd_ = -1; }
+		const std::string path = dir + "/" + base;
+		if (ring()) {
+			ring_next_ = ring_count_ = 0;
+			path_ = path;
+			return true;
+		}
+		used_ = 0;  // Pending records belong to the previous run's file
+		if (fd_ >= 0 && path == path_ && ::ftruncate(fd_, 0) == 0 &&
+		    ::lseek(fd_, 0, SEEK_SET) == 0) {
+			put_header();
+			return true;
+		}
+		close();
 		utils::ensure_dir(dir);
-		path_ = dir + "/" + base;
-		int fd = ::open(path_.c_str(), O_CREAT | O_WRONLY | O_TRUNC, 0644);
+		path_ = path;
+		int fd = ::open(path_.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
 		if (fd < 0) return false;
-		const char* hdr = "#pc_r,pc_w,insn,rd_addr,rd_wdata,mem_addr,mem_rmask,mem_wmask,trap\n";
-		if (::write(fd, hdr, (ssize_t)std::strlen(hdr)) < 0) { ::close(fd); return false; }
 		fd_ = fd;
+		if (buf_.empty()) buf_.resize(kBufferBytes);
+		put_header();
 		return true;
 	}
 
 	/**
-	 * @brief Write a commit record to the trace file
+	 * @brief Append a commit record to the trace
 	 * 
-	 * Formats the record as a CSV line and writes it to the file. If the
-	 * file is not open, this is a no-op. Writing is unbuffered to ensure
-	 * traces are preserved even if the fuzzer crashes.
+	 * Packs the record (or formats a CSV line) into the buffer. The buffer
+	 * is written out when full, by flush() and by close(). If the file is
+	 * not open, this is a no-op.
 	 * 
 	 * @param r CommitRec containing instruction execution details
 	 * 
@@ -340,22 +484,83 @@ public:
 	 *   rec.insn = 0x00000013;  // nop
 	 *   rec.rd_addr = 0;
 	 *   trace.write(rec);
-	 *   // Writes: "0x80000000,0x80000004,0x00000013,0,0x00000000,0x00000000,0x0,0x0,0\n"
+	 *   // CSV: "0x80000000,0x80000004,0x00000013,0,0x00000000,0x00000000,0x0,0x0,0\n"
 	 * @endcode
 	 */
 	void write(const CommitRec& r) {
+		if (ring()) {
+			ring_[ring_next_] = r;
+			if (++ring_next_ == ring_.size()) ring_next_ = 0;
+			if (ring_count_ < ring_.size()) ++ring_count_;
+			return;
+		}
 		if (fd_ < 0) return;
-		char line[256];
+		if (buf_.size() - used_ < kMaxEntryBytes) flush();
+		char* out = buf_.data() + used_;
+		if (format_ == Format::Binary) {
+			trace_format::pack(r, reinterpret_cast<uint8_t*>(out));
+			used_ += trace_format::kRecordBytes;
+			return;
+		}
 		// Use hex for wide fields; rd_addr/trap in decimal for readability
-		int n = std::snprintf(line, sizeof(line),
+		int n = std::snprintf(out, kMaxEntryBytes,
 										"0x%08x,0x%08x,0x%08x,%u,0x%08x,0x%08x,0x%x,0x%x,%u\n",
 										r.pc_r, r.pc_w, r.insn,
 										(unsigned)r.rd_addr, r.rd_wdata,
 										r.mem_addr, r.mem_rmask, r.mem_wmask,
 										(unsigned)r.trap);
-		if (n > 0) {
-			utils::safe_write_all(fd_, line, (size_t)n);
+		if (n > 0) used_ += (size_t)n;
+	}
+
+	/**
+	 * @brief Write buffered records to the file
+	 * 
+	 * Call once a run is over (or before the process may die) so the file
+	 * holds the complete trace.
+	 */
+	void flush() {
+		if (fd_ >= 0 && used_) utils::safe_write_all(fd_, buf_.data(), used_);
+		used_ = 0;
+	}
+
+	/**
+	 * @brief Write the recorded commits, oldest first, as a binary trace
+	 * 
+	 * Writes @p path, and the file open() named so the trace directory
+	 * holds the last finding's trace. No-op unless in flight-recorder mode
+	 * and open() was called.
+	 * 
+	 * @param path Extra copy to write (e.g. next to a crash artifact); may be empty
+	 */
+	void dump_ring(const std::string& path) const {
+		if (!ring() || path_.empty()) return;
+		std::vector<uint8_t> out(sizeof(trace_format::Header) +
+		                         ring_count_ * trace_format::kRecordBytes);
+		const trace_format::Header h = trace_format::make_header(0);
+		std::memcpy(out.data(), &h, sizeof(h));
+		uint8_t* p = out.data() + sizeof(h);
+		size_t i = ring_count_ < ring_.size() ? 0 : ring_next_;
+		for (size_t n = 0; n < ring_count_; ++n, p += trace_format::kRecordBytes) {
+			trace_format::pack(ring_[i], p);
+			if (++i == ring_.size()) i = 0;
 		}
+		const size_t slash = path_.rfind('/');
+		if (slash != std::string::npos) utils::ensure_dir(path_.substr(0, slash));
+		for (const std::string& target : {path_, path}) {
+			if (target.empty()) continue;
+			int fd = ::open(target.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+			if (fd < 0) continue;
+			utils::safe_write_all(fd, out.data(), out.size());
+			::close(fd);
+		}
+	}
+
+	/**
+	 * @brief Flush and close the file (no-op if not open)
+	 */
+	void close() {
+		flush();
+		if (fd_ >= 0) { ::close(fd_); fd_ = -1; }
 	}
 
 	/**
@@ -376,6 +581,21 @@ public:
 	const std::string& path() const { return path_; }
 
 private:
+	static constexpr size_t kBufferBytes = 1u << 20;
+	static constexpr size_t kMaxEntryBytes = 256;  ///< Room kept for one record or CSV line
+
+	void put_header() {
+		if (format_ == Format::Binary) {
+			const trace_format::Header h = trace_format::make_header(0);
+			std::memcpy(buf_.data(), &h, sizeof(h));
+			used_ = sizeof(h);
+		} else {
+			const char* hdr = "#pc_r,pc_w,insn,rd_addr,rd_wdata,mem_addr,mem_rmask,mem_wmask,trap\n";
+			used_ = std::strlen(hdr);
+			std::memcpy(buf_.data(), hdr, used_);
+		}
+	}
+
 	/**
 	 * @brief File descriptor for open trace file (-1 if closed)
 	 */
@@ -385,4 +605,12 @@ private:
 	 * @brief Full path to the trace file
 	 */
 	std::string path_;
+
+	Format format_ = Format::Binary;
+	std::vector<char> buf_;  ///< Pending output, allocated on first open
+	size_t used_ = 0;
+
+	std::vector<CommitRec> ring_;  ///< Flight recorder (empty when writing files)
+	size_t ring_next_ = 0;         ///< Slot the next record goes to
+	size_t ring_count_ = 0;        ///< Records held, up to ring_.size()
 };
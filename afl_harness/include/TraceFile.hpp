@@ -0,0 +1,65 @@
+/**
+ * @file TraceFile.hpp
+ * @brief Whole-file loading and saving of recorded commit streams
+ *
+ * Feeds GOLDEN_MODE=replay and tools/trace_convert. Three input formats are
+ * recognised from the file contents:
+ *
+ *   binary    trace_format header + packed records (every CommitRec field)
+ *   CSV       golden.trace / dut.trace as written by TraceWriter
+ *   Spike log raw `spike -l` output, or a SPIKE_LOG_FILE excerpt
+ *
+ * CSV traces carry no load/store flags or memory data; the flags are
+ * recovered from the masks, or from the opcode when the masks are zero
+ * (golden traces recorded from Spike).
+ */
+
+#pragma once
+
+#include "Trace.hpp"
+#include <string>
+#include <vector>
+
+/**
+ * @class TraceFile
+ * @brief A commit stream held in memory, read from or written to one file
+ *
+ * Example usage:
+ * @code
+ *   TraceFile trace;
+ *   if (!trace.load("workdir/traces/golden.trace")) { ... trace.error() ... }
+ *   for (const CommitRec& rec : trace.commits()) { ... }
+ *   TraceFile::save("golden.bin", trace.commits(), trace.finished());
+ * @endcode
+ */
+class TraceFile {
+public:
+  enum class Format { Binary, Csv, SpikeLog };
+
+  /// @brief Read all commits of @p path, replacing the current contents
+  /// @return False if the file cannot be read or has a bad binary header
+  bool load(const std::string& path);
+
+  const std::vector<CommitRec>& commits() const { return commits_; }
+  Format format() const { return format_; }
+
+  /// @brief True if the recorded run ended cleanly
+  /// @note Binary: header flag; CSV: always; Spike log: no fatal trap
+  bool finished() const { return finished_; }
+
+  const std::string& error() const { return error_; }
+
+  /// @brief Write @p commits as a binary trace (temp file + rename)
+  static bool save(const std::string& path, const std::vector<CommitRec>& commits,
+                   bool finished);
+
+private:
+  bool parse_binary(const std::string& data);
+  void parse_csv(const std::string& data);
+  void parse_spike_log(const std::string& data);
+
+  std::vector<CommitRec> commits_;
+  Format format_ = Format::Binary;
+  bool finished_ = false;
+  std::string error_;
+};
@@ -0,0 +1,360 @@
+/**
+ * @file BatchMain.cpp
+ * @brief In-process, multi-threaded corpus executor
+ *
+ * Runs every input of one or more corpus directories (or explicit files)
+ * through the same checks as the AFL++ harness, with one DUT per worker
+ * thread. Used to regress a whole queue after an RTL change without
+ * spawning the harness once per seed.
+ *
+ * With --watch it is the offline half of GOLDEN_MODE=batch: the fuzzers run
+ * the DUT alone, and this process follows their queues and runs every new
+ * entry through the DUT and the golden model on spare cores.
+ *
+ * Usage:
+ *   batch_picorv32 [-j N] <dir|file|@listfile>...
+ *   batch_picorv32 --watch [-j N] [--interval S] [--state FILE] <afl_out_dir>...
+ *
+ * Crash artifacts go to the usual crash directory, tagged with the worker
+ * number. Exit status is 0 when every input exits gracefully, 1 otherwise;
+ * a watcher runs until SIGINT/SIGTERM and then exits 0.
+ */
+
+#include "HarnessConfig.hpp"
+#include "CpuIface.hpp"
+#include "CrashLogger.hpp"
+#include "Execution.hpp"
+#include "Trace.hpp"
+#include "GoldenModel.hpp"
+#include "DifferentialChecker.hpp"
+
+#include <hwfuzz/Debug.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+extern "C" CpuIface* make_cpu();
+
+static const size_t kMaxInputBytes = 1 << 20;  // Same cap as the AFL++ harness
+
+// Queue entries younger than this may still be being written by afl-fuzz
+static const auto kSettleTime = std::chrono::seconds(1);
+
+static volatile std::sig_atomic_t g_watch_stop = 0;
+
+static void watch_stop_handler(int) { g_watch_stop = 1; }
+
+// ============================================================================
+// Input Collection
+// ============================================================================
+
+static void add_path(const fs::path& p, std::vector<std::string>& out) {
+  std::error_code ec;
+  if (fs::is_directory(p, ec)) {
+    // AFL++ queue dirs also hold .state/ and README.txt; only take seeds
+    for (const auto& entry : fs::directory_iterator(p, ec)) {
+      const std::string name = entry.path().filename().string();
+      if (!entry.is_regular_file(ec) || name.empty() || name[0] == '.' ||
+          name == "README.txt") {
+        continue;
+      }
+      out.push_back(entry.path().string());
+    }
+  } else if (fs::is_regular_file(p, ec)) {
+    out.push_back(p.string());
+  } else {
+    hwfuzz::debug::logWarn("[BATCH] Skipping %s (not a file or directory)\n", p.string().c_str());
+  }
+}
+
+/// Expands directories and @listfiles (one path per line) into input files.
+static std::vector<std::string> collect_inputs(const std::vector<std::string>& args) {
+  std::vector<std::string> files;
+  for (const std::string& arg : args) {
+    if (!arg.empty() && arg[0] == '@') {
+      std::ifstream list(arg.substr(1));
+      std::string line;
+      while (std::getline(list, line)) {
+        if (!line.empty() && line[0] != '#') add_path(line, files);
+      }
+    } else {
+      add_path(arg, files);
+    }
+  }
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+static void read_input(const std::string& path, std::vector<unsigned char>& out) {
+  out.clear();
+  std::ifstream f(path, std::ios::binary);
+  if (f) {
+    out.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    if (out.size() > kMaxInputBytes) out.resize(kMaxInputBytes);
+  }
+  if (out.empty()) {
+    out.push_back(0x13);  // ADDI x0,x0,0, same placeholder as the harness
+  }
+}
+
+// ============================================================================
+// Worker Pool
+// ============================================================================
+
+/// Workers pull the next unclaimed input from a shared atomic index. Inputs
+/// are independent and claimed one at a time, so a worker stuck on a slow
+/// input never holds back work that others could take.
+static void worker_main(unsigned id, const std::string& tag, CpuIface* cpu,
+                        const HarnessConfig& cfg, const std::vector<std::string>& files,
+                        std::atomic<size_t>& next, std::vector<ExecOutcome>& outcomes) {
+  CrashLogger logger(cfg, tag + "w" + std::to_string(id));
+  TraceWriter tracer;
+  GoldenModel golden;
+  DifferentialChecker diff_checker;
+  diff_checker.set_checkpoint(cfg.diff_checkpoint);
+  if (cfg.mem_digest) {
+    cpu->track_writes(true);
+    diff_checker.enable_memory_digest(cfg.tohost_addr);
+  }
+  golden.configure();
+  golden.set_limits(cfg.max_cycles, cfg.pc_stagnation_limit);
+
+  const ExecutionContext ctx{cpu, cfg, logger, tracer, golden, diff_checker, false};
+  std::vector<unsigned char> input;
+  input.reserve(1024);
+
+  for (size_t i = next.fetch_add(1); i < files.size(); i = next.fetch_add(1)) {
+    read_input(files[i], input);
+    outcomes[i] = execution::run_one_input(ctx, input);
+    if (outcomes[i] != ExecOutcome::Graceful) {
+      hwfuzz::debug::logWarn("[BATCH] worker %u: %s -> %s\n", id, files[i].c_str(),
+                             outcomes[i] == ExecOutcome::Timeout ? "timeout" : "crash");
+    }
+  }
+}
+
+/// Runs @p files on up to cpus.size() workers; returns one outcome per file.
+static std::vector<ExecOutcome> run_pool(const std::vector<std::unique_ptr<CpuIface>>& cpus,
+                                         const HarnessConfig& cfg,
+                                         const std::vector<std::string>& files,
+                                         const std::string& tag) {
+  const unsigned jobs = (unsigned)std::min(cpus.size(), files.size());
+  std::atomic<size_t> next{0};
+  std::vector<ExecOutcome> outcomes(files.size(), ExecOutcome::Graceful);
+  std::vector<std::thread> workers;
+  for (unsigned w = 0; w < jobs; ++w) {
+    workers.emplace_back(worker_main, w, std::cref(tag), cpus[w].get(), std::cref(cfg),
+                         std::cref(files), std::ref(next), std::ref(outcomes));
+  }
+  for (std::thread& t : workers) t.join();
+  return outcomes;
+}
+
+/// Prints failing inputs and adds them to @p crashes / @p timeouts.
+static void report_failures(const std::vector<std::string>& files,
+                            const std::vector<ExecOutcome>& outcomes,
+                            size_t& crashes, size_t& timeouts) {
+  for (size_t i = 0; i < files.size(); ++i) {
+    if (outcomes[i] == ExecOutcome::Graceful) continue;
+    if (outcomes[i] == ExecOutcome::Timeout) ++timeouts; else ++crashes;
+    std::printf("  %-7s %s\n", outcomes[i] == ExecOutcome::Timeout ? "TIMEOUT" : "CRASH",
+                files[i].c_str());
+  }
+}
+
+// ============================================================================
+// Watch Mode (offline half of GOLDEN_MODE=batch)
+// ============================================================================
+
+/// An AFL++ output dir holds one <instance>/queue per fuzzer; a plain
+/// directory is watched as is. Re-evaluated every scan, so instances that
+/// start after the watcher are picked up.
+static std::vector<std::string> queue_dirs(const std::vector<std::string>& roots) {
+  std::vector<std::string> dirs;
+  std::error_code ec;
+  for (const std::string& root : roots) {
+    if (fs::is_directory(fs::path(root) / "queue", ec)) {
+      dirs.push_back((fs::path(root) / "queue").string());
+      continue;
+    }
+    bool found = false;
+    for (const auto& entry : fs::directory_iterator(root, ec)) {
+      if (fs::is_directory(entry.path() / "queue", ec)) {
+        dirs.push_back((entry.path() / "queue").string());
+        found = true;
+      }
+    }
+    if (!found && fs::is_directory(root, ec)) dirs.push_back(root);
+  }
+  return dirs;
+}
+
+static int watch(const std::vector<std::unique_ptr<CpuIface>>& cpus, const HarnessConfig& cfg,
+                 const std::vector<std::string>& roots, unsigned interval,
+                 const std::string& state_path) {
+  // Inputs checked by an earlier watcher run are listed one path per line
+  std::unordered_set<std::string> done;
+  if (!state_path.empty()) {
+    std::ifstream in(state_path);
+    std::string line;
+    while (std::getline(in, line)) done.insert(line);
+  }
+  std::ofstream state;
+  if (!state_path.empty()) state.open(state_path, std::ios::app);
+
+  struct sigaction sa;
+  std::memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = watch_stop_handler;
+  sigaction(SIGINT, &sa, nullptr);
+  sigaction(SIGTERM, &sa, nullptr);
+
+  std::printf("[BATCH] Watching %zu location(s), %zu worker(s), %zu input(s) already checked\n",
+              roots.size(), cpus.size(), done.size());
+  std::fflush(stdout);
+
+  size_t checked = 0, crashes = 0, timeouts = 0;
+  for (unsigned round = 0; !g_watch_stop; ++round) {
+    std::vector<std::string> fresh;
+    const auto now = fs::file_time_type::clock::now();
+    std::error_code ec;
+    for (const std::string& file : collect_inputs(queue_dirs(roots))) {
+      // Entries synced from another instance were checked in its own queue
+      if (done.count(file) || file.find(",sync:") != std::string::npos) continue;
+      const auto mtime = fs::last_write_time(file, ec);
+      if (ec || now - mtime < kSettleTime) continue;  // Next round
+      fresh.push_back(file);
+    }
+
+    if (!fresh.empty()) {
+      const auto outcomes = run_pool(cpus, cfg, fresh, "r" + std::to_string(round));
+      size_t c = 0, t = 0;
+      report_failures(fresh, outcomes, c, t);
+      checked += fresh.size();
+      crashes += c;
+      timeouts += t;
+      for (const std::string& file : fresh) {
+        done.insert(file);
+        if (state) state << file << '\n';
+      }
+      state.flush();
+      std::printf("[BATCH] %zu new, %zu crashed, %zu timed out (total %zu checked, %zu failed)\n",
+                  fresh.size(), c, t, checked, crashes + timeouts);
+      std::fflush(stdout);
+      continue;  // Rescan right away: the fuzzers kept going meanwhile
+    }
+    for (unsigned s = 0; s < interval * 10 && !g_watch_stop; ++s) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+  }
+
+  std::printf("[BATCH] Watch stopped: %zu checked, %zu crashed, %zu timed out\n",
+              checked, crashes, timeouts);
+  std::printf("[BATCH] Crash artifacts: %s\n", cfg.crash_dir.c_str());
+  return 0;
+}
+
+static void usage(const char* argv0) {
+  std::fprintf(stderr,
+               "Usage: %s [-j N] <dir|file|@listfile>...\n"
+               "       %s --watch [-j N] [--interval S] [--state FILE] <afl_out_dir>...\n",
+               argv0, argv0);
+}
+
+int main(int argc, char** argv) {
+  unsigned jobs = std::thread::hardware_concurrency();
+  std::vector<std::string> args;
+  bool watch_mode = false;
+  unsigned interval = 5;
+  std::string state_path;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "-j" && i + 1 < argc) {
+      jobs = (unsigned)std::strtoul(argv[++i], nullptr, 0);
+    } else if (a == "--watch") {
+      watch_mode = true;
+    } else if (a == "--interval" && i + 1 < argc) {
+      interval = (unsigned)std::strtoul(argv[++i], nullptr, 0);
+    } else if (a == "--state" && i + 1 < argc) {
+      state_path = argv[++i];
+    } else if (a == "-h" || a == "--help") {
+      usage(argv[0]);
+      return 0;
+    } else {
+      args.push_back(a);
+    }
+  }
+  if (args.empty()) {
+    usage(argv[0]);
+    return 2;
+  }
+  if (jobs == 0) jobs = 1;
+
+  execution::install_signal_handlers();
+
+  HarnessConfig cfg;
+  cfg.loadconfig();
+
+  // Per-input trace files would be shared by every worker; batch runs only
+  // report crashes. Set before any GoldenModel reads the environment.
+  setenv("TRACE_MODE", "off", 1);
+
+  // GOLDEN_MODE=batch means "no golden model in the fuzzer": this process is
+  // where the golden checks happen, with the backend GOLDEN_BATCH_BACKEND names
+  const char* mode = std::getenv("GOLDEN_MODE");
+  if (mode && std::string(mode) == "batch") {
+    const char* backend = std::getenv("GOLDEN_BATCH_BACKEND");
+    setenv("GOLDEN_MODE", backend && *backend ? backend : "live", 1);
+  }
+
+  if (watch_mode) {
+    std::vector<std::unique_ptr<CpuIface>> cpus;
+    for (unsigned w = 0; w < jobs; ++w) {
+      cpus.emplace_back(make_cpu());
+    }
+    return watch(cpus, cfg, args, interval, state_path);
+  }
+
+  const std::vector<std::string> files = collect_inputs(args);
+  if (files.empty()) {
+    std::fprintf(stderr, "[BATCH] No inputs found\n");
+    return 2;
+  }
+  if (jobs > files.size()) jobs = (unsigned)files.size();
+
+  // One independent DUT per worker, built up front on this thread
+  std::vector<std::unique_ptr<CpuIface>> cpus;
+  for (unsigned w = 0; w < jobs; ++w) {
+    cpus.emplace_back(make_cpu());
+  }
+
+  std::printf("[BATCH] %zu input(s), %u worker(s)\n", files.size(), jobs);
+  const auto start = std::chrono::steady_clock::now();
+
+  const std::vector<ExecOutcome> outcomes = run_pool(cpus, cfg, files, "");
+
+  const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  size_t crashes = 0, timeouts = 0;
+  report_failures(files, outcomes, crashes, timeouts);
+
+  std::printf("[BATCH] %zu passed, %zu crashed, %zu timed out in %.1f s (%.0f execs/s)\n",
+              files.size() - crashes - timeouts, crashes, timeouts, secs,
+              secs > 0 ? files.size() / secs : 0.0);
+  std::printf("[BATCH] Crash artifacts: %s\n", cfg.crash_dir.c_str());
+
+  return (crashes || timeouts) ? 1 : 0;
+}
@@ -1,73 +1,138 @@
 #include "CpuIface.hpp"
+#include "MemoryMap.hpp"
+#include "MemoryLayout.hpp"
 #include "Vpicorv32.h"
+#include "Vpicorv32___024root.h"
 #include "verilated.h"
 
 #include <cstring>
+#include <cstdlib>
 #include <vector>
 #include <cstdint>
+#include <memory>
 
-static const size_t MEM_BYTES = 64 * 1024;
-static uint8_t mem_area[MEM_BYTES];
-
-static inline void tick(Vpicorv32 *t) { t->clk = 0; t->eval(); t->clk = 1; t->eval(); }
-
-static inline uint32_t mem_read32(uint32_t addr) {
-  uint32_t a = (addr & (MEM_BYTES - 1)) & ~0x3u;
-  return (uint32_t)mem_area[a] |
-         ((uint32_t)mem_area[a+1] << 8) |
-         ((uint32_t)mem_area[a+2] << 16) |
-         ((uint32_t)mem_area[a+3] << 24);
-}
-
-static inline void mem_write32(uint32_t addr, uint32_t data, uint8_t wstrb) {
-  uint32_t a = (addr & (MEM_BYTES - 1)) & ~0x3u;
-  if (wstrb & 1) mem_area[a+0] = (uint8_t)(data & 0xFF);
-  if (wstrb & 2) mem_area[a+1] = (uint8_t)((data >> 8) & 0xFF);
-  if (wstrb & 4) mem_area[a+2] = (uint8_t)((data >> 16) & 0xFF);
-  if (wstrb & 8) mem_area[a+3] = (uint8_t)((data >> 24) & 0xFF);
-}
-
+// Each instance owns its VerilatedContext, model and memory, so several
+// instances can be driven from different threads at the same time.
 class CpuPicoRV32 final : public CpuIface {
 public:
-    CpuPicoRV32() {
+    CpuPicoRV32() : ctx_(new VerilatedContext) {
     #if VL_VER_MAJOR >= 5
-        Verilated::randReset(0);
+        ctx_->randReset(0);
     #else
-        Verilated::randSeed(0);
+        ctx_->randSeed(0);
     #endif
-        top_ = new Vpicorv32;
+        top_ = new Vpicorv32(ctx_.get());
+
+        // Must match the reset vector the RTL was built with (tools/memory_config.mk)
+        const MemoryLayout layout = MemoryLayout::from_env();
+        load_base_ = layout.reset_vector;
+        // Program image spans from the reset vector to the end of RAM
+        max_input_ = layout.image_size();
+        mem_.ram().reserve(load_base_, (uint32_t)max_input_);
+
+        // MMIO devices; tohost is always mapped, UART/timer only on request
+        if (const char* th = std::getenv("TOHOST_ADDR")) {
+          if (*th) {
+            uint32_t tohost = (uint32_t)std::strtoul(th, nullptr, 0);
+            mem_.add_device(tohost, PagedMemory::kPageSize,
+                            std::unique_ptr<BusDevice>(new ToHostDevice(mem_.ram(), mem_.events(), tohost)));
+            tohost_on_bus_ = true;
+          }
+        }
+        if (uint32_t uart = env_addr("UART_ADDR", 0)) {
+          mem_.add_device(uart, PagedMemory::kPageSize, std::unique_ptr<BusDevice>(new UartDevice(uart)));
+        }
+        if (uint32_t timer = env_addr("TIMER_ADDR", 0)) {
+          mem_.add_device(timer, PagedMemory::kPageSize,
+                          std::unique_ptr<BusDevice>(new TimerDevice(timer, cycles_)));
+        }
     }
     ~CpuPicoRV32() override { delete top_; }
 
 
 // Clears memory and resets the CPU for 8 cycles.
+    // Also clears a pending $finish so the model can be reused across inputs.
     void reset() override {
-      std::memset(mem_area, 0, sizeof(mem_area));
+      mem_.reset();
+      writes_.reset();
+      cycles_ = 0;
+      ctx_->gotFinish(false);
       top_->resetn    = 0;
       top_->mem_valid = 0;
       top_->mem_ready = 0;
       top_->mem_wstrb = 0;
-      for (int i = 0; i < 8; ++i) tick(top_);
+      for (int i = 0; i < 8; ++i) tick();
       top_->resetn = 1;
     }
 
-    // Loads binary input into memory (up to 64 KB).
-    void load_input(const std::vector<unsigned char>& in) override {
-      size_t copy_n = in.size() > MEM_BYTES ? MEM_BYTES : in.size();
-      std::memcpy(mem_area, in.data(), copy_n);
+    // Raw copy of the model's root state struct. The picorv32 model is
+    // built without --timing, so the struct is plain data (ports, registers,
+    // unpacked arrays) and a memcpy round-trips it exactly.
+    bool save_state() override {
+      snapshot_.resize(sizeof(Vpicorv32___024root));
+      std::memcpy(snapshot_.data(), static_cast<const void*>(top_->rootp), snapshot_.size());
+      return true;
     }
 
-    void step() override {
-      top_->mem_ready = 0;
-      if (top_->mem_valid) {
-        if (top_->mem_wstrb) mem_write32(top_->mem_addr, top_->mem_wdata, top_->mem_wstrb);
-        else                 top_->mem_rdata = mem_read32(top_->mem_addr);
-        top_->mem_ready = 1;
+    // Memory is all zero right after reset(), so it is cleared rather than saved.
+    bool restore_state() override {
+      if (snapshot_.size() != sizeof(Vpicorv32___024root)) return false;
+      mem_.reset();
+      writes_.reset();
+      cycles_ = 0;
+      ctx_->gotFinish(false);
+      std::memcpy(static_cast<void*>(top_->rootp), snapshot_.data(), snapshot_.size());
+      return true;
+    }
+
+    // Loads binary input at the reset vector (up to the end of RAM).
+    void load_input(const unsigned char* data, size_t len) override {
+      size_t copy_n = len > max_input_ ? max_input_ : len;
+      mem_.ram().load(load_base_, data, copy_n);
+    }
+
+    void step() override { cycle(); }
+
+    // Same contract as CpuIface::run_until_commit(), but reads the model's
+    // signals directly: one virtual call per retired instruction.
+    CommitStatus run_until_commit(CommitRec& rec, unsigned max_cycles, unsigned& cycles) override {
+      for (cycles = 0; cycles < max_cycles;) {
+        cycle();
+        ++cycles;
+        if (ctx_->gotFinish()) return CommitStatus::Finish;
+        if (top_->rvfi_valid) {
+          rec.pc_r      = top_->rvfi_pc_rdata;
+          rec.pc_w      = top_->rvfi_pc_wdata;
+          rec.insn      = top_->rvfi_insn;
+          rec.rd_addr   = top_->rvfi_rd_addr;
+          rec.rd_wdata  = top_->rvfi_rd_wdata;
+          rec.mem_addr  = top_->rvfi_mem_addr;
+          rec.mem_rmask = top_->rvfi_mem_rmask;
+          rec.mem_wmask = top_->rvfi_mem_wmask;
+          rec.mem_wdata = top_->rvfi_mem_wdata;
+          rec.mem_rdata = top_->rvfi_mem_rdata;
+          rec.trap      = top_->rvfi_trap ? 1u : 0u;
+          rec.csr_mcycle_wmask   = top_->rvfi_csr_mcycle_wmask;
+          rec.csr_mcycle_wdata   = top_->rvfi_csr_mcycle_wdata;
+          rec.csr_minstret_wmask = top_->rvfi_csr_minstret_wmask;
+          rec.csr_minstret_wdata = top_->rvfi_csr_minstret_wdata;
+          return CommitStatus::Commit;
+        }
+        // Raised at bus time; if an instruction retired on the same cycle it
+        // is returned first and the exit follows after the next cycle
+        if (mem_.events().exit) return CommitStatus::DeviceExit;
+        if (top_->rvfi_trap) {
+          rec.pc_r = top_->rvfi_pc_rdata;
+          rec.insn = top_->rvfi_insn;
+          rec.trap = 1u;
+          return CommitStatus::Trap;
+        }
       }
-      tick(top_);
+      return CommitStatus::Budget;
     }
 
-    bool      got_finish()              const override { return Verilated::gotFinish();         }
+    bool      got_finish()              const override { return ctx_->gotFinish();              }
+    bool      handles_tohost()          const override { return tohost_on_bus_;                 }
     bool      trap()                    const override { return top_->rvfi_trap;                }
     bool      rvfi_valid()              const override { return top_->rvfi_valid;               }
     uint32_t  rvfi_insn()               const override { return top_->rvfi_insn;                }
@@ -78,13 +143,52 @@ public:
     uint32_t  rvfi_mem_addr()           const override { return top_->rvfi_mem_addr;            }
     uint32_t  rvfi_mem_rmask()          const override { return top_->rvfi_mem_rmask;           }
     uint32_t  rvfi_mem_wmask()          const override { return top_->rvfi_mem_wmask;           }
+    uint32_t  rvfi_mem_wdata()          const override { return top_->rvfi_mem_wdata;           }
+    uint32_t  rvfi_mem_rdata()          const override { return top_->rvfi_mem_rdata;           }
+    void track_writes(bool on) override { track_writes_ = on; writes_.reset(); }
+    const MemDigest* write_digest() const override { return track_writes_ ? &writes_ : nullptr; }
+
     uint64_t  rvfi_csr_mcycle_wmask()   const override { return top_->rvfi_csr_mcycle_wmask;    }
     uint64_t  rvfi_csr_mcycle_wdata()   const override { return top_->rvfi_csr_mcycle_wdata;    }
     uint64_t  rvfi_csr_minstret_wmask() const override { return top_->rvfi_csr_minstret_wmask;  }
     uint64_t  rvfi_csr_minstret_wdata() const override { return top_->rvfi_csr_minstret_wdata;  }
 
   private:
+    static constexpr size_t DEFAULT_MAX_INPUT = 64 * 1024;
+
+    void tick() { top_->clk = 0; top_->eval(); top_->clk = 1; top_->eval(); }
+
+    // Serves a pending bus request, then clocks the model once. The transfer
+    // completes on the first edge after mem_valid rises, which is the fastest
+    // the native PicoRV32 bus allows.
+    void cycle() {
+      top_->mem_ready = 0;
+      if (top_->mem_valid) {
+        if (top_->mem_wstrb) {
+          mem_.write32(top_->mem_addr, top_->mem_wdata, top_->mem_wstrb);
+          if (track_writes_) writes_.store(top_->mem_addr, top_->mem_wdata, top_->mem_wstrb);
+        } else {
+          top_->mem_rdata = mem_.read32(top_->mem_addr);
+        }
+        top_->mem_ready = 1;
+      }
+      tick();
+      ++cycles_;
+    }
+
+    std::unique_ptr<VerilatedContext> ctx_;  // Per-instance $finish flag and RNG
     Vpicorv32* top_ = nullptr;
+    MemoryMap mem_;                   // RAM (sparse 32-bit space) + MMIO devices
+    uint64_t cycles_ = 0;             // Cycles since reset (timer device)
+    bool tohost_on_bus_ = false;      // ToHostDevice mapped at TOHOST_ADDR
+    uint32_t load_base_ = 0;          // Input load address (PROGADDR_RESET)
+    size_t max_input_ = DEFAULT_MAX_INPUT;
+    std::vector<uint8_t> snapshot_;   // Post-reset model state (save_state())
+
+    // MEM_DIGEST: every bus write since reset, for the end-of-run memory check
+    bool track_writes_ = false;
+    MemDigest writes_;
 };
 
+// Returns a new, independent instance on every call (caller owns it).
 extern "C" CpuIface* make_cpu() { return new CpuPicoRV32(); }
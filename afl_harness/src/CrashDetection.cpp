@@ -8,34 +8,31 @@
 
 namespace crash_detection {
 
-bool check_x0_write(const CpuIface* cpu, const CrashLogger& logger, 
-                    unsigned cyc, const std::vector<unsigned char>& input) {
-  if (!cpu->rvfi_valid()) return false;
-  uint32_t rd = cpu->rvfi_rd_addr();
-  uint32_t w  = cpu->rvfi_rd_wdata();
+bool check_x0_write(const CommitRec& rec, const CrashLogger& logger, 
+                    unsigned cyc, InputView input) {
+  uint32_t rd = rec.rd_addr;
+  uint32_t w  = rec.rd_wdata;
   if (rd == 0 && w != 0) {
-    logger.writeCrash("x0_write", cpu->rvfi_pc_rdata(), cpu->rvfi_insn(), cyc, input);
+    logger.writeCrash("x0_write", rec.pc_r, rec.insn, cyc, input);
     return true;
   }
   return false;
 }
 
-bool check_pc_misaligned(const CpuIface* cpu, const CrashLogger& logger,
-                         unsigned cyc, const std::vector<unsigned char>& input) {
-  if (!cpu->rvfi_valid()) return false;
-  uint32_t pcw = cpu->rvfi_pc_wdata();
+bool check_pc_misaligned(const CommitRec& rec, const CrashLogger& logger,
+                         unsigned cyc, InputView input) {
+  uint32_t pcw = rec.pc_w;
   if ((pcw & 0x1) != 0) {
-    logger.writeCrash("pc_misaligned", cpu->rvfi_pc_rdata(), cpu->rvfi_insn(), cyc, input);
+    logger.writeCrash("pc_misaligned", rec.pc_r, rec.insn, cyc, input);
     return true;
   }
   return false;
 }
 
-bool check_mem_align_load(const CpuIface* cpu, const CrashLogger& logger,
-                          unsigned cyc, const std::vector<unsigned char>& input) {
-  if (!cpu->rvfi_valid()) return false;
-  uint32_t addr = cpu->rvfi_mem_addr();
-  uint32_t mask = cpu->rvfi_mem_rmask() & 0xFu;
+bool check_mem_align_load(const CommitRec& rec, const CrashLogger& logger,
+                          unsigned cyc, InputView input) {
+  uint32_t addr = rec.mem_addr;
+  uint32_t mask = rec.mem_rmask & 0xFu;
   if (!mask) return false;
 
   uint32_t off = addr & 0x3u;
@@ -45,25 +42,24 @@ bool check_mem_align_load(const CpuIface* cpu, const CrashLogger& logger,
                    (contiguous == 2 && (mask == (0x3u << off))) ||
                    (contiguous == 4 && mask == 0xFu);
   if (!is_contig) {
-    logger.writeCrash("mem_mask_irregular_load", cpu->rvfi_pc_rdata(), cpu->rvfi_insn(), cyc, input);
+    logger.writeCrash("mem_mask_irregular_load", rec.pc_r, rec.insn, cyc, input);
     return true;
   }
   if (contiguous >= 2 && (addr & 0x1)) {
-    logger.writeCrash("mem_unaligned_load", cpu->rvfi_pc_rdata(), cpu->rvfi_insn(), cyc, input);
+    logger.writeCrash("mem_unaligned_load", rec.pc_r, rec.insn, cyc, input);
     return true;
   }
   if (contiguous >= 4 && (addr & 0x3)) {
-    logger.writeCrash("mem_unaligned_load", cpu->rvfi_pc_rdata(), cpu->rvfi_insn(), cyc, input);
+    logger.writeCrash("mem_unaligned_load", rec.pc_r, rec.insn, cyc, input);
     return true;
   }
   return false;
 }
 
-bool check_mem_align_store(const CpuIface* cpu, const CrashLogger& logger,
-                           unsigned cyc, const std::vector<unsigned char>& input) {
-  if (!cpu->rvfi_valid()) return false;
-  uint32_t addr = cpu->rvfi_mem_addr();
-  uint32_t mask = cpu->rvfi_mem_wmask() & 0xFu;
+bool check_mem_align_store(const CommitRec& rec, const CrashLogger& logger,
+                           unsigned cyc, InputView input) {
+  uint32_t addr = rec.mem_addr;
+  uint32_t mask = rec.mem_wmask & 0xFu;
   if (!mask) return false;
 
   uint32_t off = addr & 0x3u;
@@ -73,22 +69,22 @@ bool check_mem_align_store(const CpuIface* cpu, const CrashLogger& logger,
                    (contiguous == 2 && (mask == (0x3u << off))) ||
                    (contiguous == 4 && mask == 0xFu);
   if (!is_contig) {
-    logger.writeCrash("mem_mask_irregular_store", cpu->rvfi_pc_rdata(), cpu->rvfi_insn(), cyc, input);
+    logger.writeCrash("mem_mask_irregular_store", rec.pc_r, rec.insn, cyc, input);
     return true;
   }
   if (contiguous >= 2 && (addr & 0x1)) {
-    logger.writeCrash("mem_unaligned_store", cpu->rvfi_pc_rdata(), cpu->rvfi_insn(), cyc, input);
+    logger.writeCrash("mem_unaligned_store", rec.pc_r, rec.insn, cyc, input);
     return true;
   }
   if (contiguous >= 4 && (addr & 0x3)) {
-    logger.writeCrash("mem_unaligned_store", cpu->rvfi_pc_rdata(), cpu->rvfi_insn(), cyc, input);
+    logger.writeCrash("mem_unaligned_store", rec.pc_r, rec.insn, cyc, input);
     return true;
   }
   return false;
 }
 
 bool check_timeout(unsigned cyc, unsigned max_cycles, const CpuIface* cpu,
-                   const CrashLogger& logger, const std::vector<unsigned char>& input) {
+                   const CrashLogger& logger, InputView input) {
   if (cyc >= max_cycles) {
     uint32_t pc   = cpu->rvfi_pc_rdata();
     uint32_t insn = cpu->rvfi_insn();
@@ -98,22 +94,21 @@ bool check_timeout(unsigned cyc, unsigned max_cycles, const CpuIface* cpu,
   return false;
 }
 
-bool check_pc_stagnation(const CpuIface* cpu, const CrashLogger& logger,
-                         unsigned cyc, const std::vector<unsigned char>& input,
+bool check_pc_stagnation(const CommitRec& rec, const CrashLogger& logger,
+                         unsigned cyc, InputView input,
                          unsigned stagnation_limit, uint32_t& last_pc,
                          bool& last_pc_valid, unsigned& stagnation_count) {
-  if (!cpu->rvfi_valid()) return false;
   if (stagnation_limit == 0) return false;  // Disabled
   
-  uint32_t pc_w = cpu->rvfi_pc_wdata();
+  uint32_t pc_w = rec.pc_w;
   
   if (last_pc_valid && pc_w == last_pc) {
     if (++stagnation_count > stagnation_limit) {
       std::ostringstream oss;
       oss << "PC stagnation detected after " << stagnation_count 
           << " commits at PC=0x" << std::hex << pc_w << std::dec << "\n";
-      oss << "Last instruction: 0x" << std::hex << cpu->rvfi_insn() << std::dec << "\n";
-      logger.writeCrash("pc_stagnation", cpu->rvfi_pc_rdata(), cpu->rvfi_insn(), 
+      oss << "Last instruction: 0x" << std::hex << rec.insn << std::dec << "\n";
+      logger.writeCrash("pc_stagnation", rec.pc_r, rec.insn, 
                        cyc, input, oss.str());
       return true;
     }
@@ -126,11 +121,11 @@ bool check_pc_stagnation(const CpuIface* cpu, const CrashLogger& logger,
   return false;
 }
 
-bool check_trap(const CpuIface* cpu, const CrashLogger& logger,
-                unsigned cyc, const std::vector<unsigned char>& input) {
-  if (cpu->trap()) {
-    uint32_t pc   = cpu->rvfi_pc_rdata();
-    uint32_t insn = cpu->rvfi_insn();
+bool check_trap(const CommitRec& rec, const CrashLogger& logger,
+                unsigned cyc, InputView input) {
+  if (rec.trap) {
+    uint32_t pc   = rec.pc_r;
+    uint32_t insn = rec.insn;
     logger.writeCrash("trap", pc, insn, cyc, input);
     return true;
   }
@@ -0,0 +1,260 @@
+#include "Execution.hpp"
+#include "CrashDetection.hpp"
+
+#include <hwfuzz/Debug.hpp>
+#include <csignal>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+namespace execution {
+
+// ============================================================================
+// Signal Handling
+// ============================================================================
+
+static volatile sig_atomic_t g_sig = 0;
+static void sig_handler(int s) { g_sig = s; }
+
+void install_signal_handlers() {
+  struct sigaction sa;
+  std::memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = sig_handler;
+  sigaction(SIGSEGV, &sa, nullptr);
+  sigaction(SIGILL,  &sa, nullptr);
+  sigaction(SIGBUS,  &sa, nullptr);
+  sigaction(SIGABRT, &sa, nullptr);
+}
+
+static void handle_signal_crash(CrashLogger& logger, TraceWriter& tracer, CpuIface* cpu,
+                                unsigned cyc, InputView input) {
+  if (g_sig) {
+    tracer.flush();
+    uint32_t pc = cpu->rvfi_pc_rdata();
+    uint32_t insn = cpu->rvfi_insn();
+    logger.writeCrash(std::string("signal_") + std::to_string(g_sig), pc, insn, cyc, input);
+    tracer.dump_ring(logger.lastCrashBase() + ".dut.trace");
+    _exit(126);
+  }
+}
+
+// ============================================================================
+// DUT Execution Loop
+// ============================================================================
+
+static bool check_exit_conditions(const CommitRec& rec, const HarnessConfig& cfg,
+                                   bool tohost_on_bus, ExecutionState& state) {
+  // Check for PC stagnation (infinite loop detection)
+  if (state.last_progress_valid && rec.pc_r == state.last_progress_pc) {
+    state.stagnation_count++;
+  } else {
+    state.last_progress_pc = rec.pc_r;
+    state.last_progress_valid = true;
+    state.stagnation_count = 0;
+  }
+
+  // Check tohost exit (unless the DUT bus already reports it)
+  if (cfg.use_tohost && !tohost_on_bus && (rec.mem_wmask & 0xF) != 0) {
+    if ((rec.mem_addr & ~0x3u) == (cfg.tohost_addr & ~0x3u)) {
+      state.exit_reason = ExitReason::Tohost;
+      state.graceful_exit = true;
+      return true;
+    }
+  }
+
+  // Check trap-based exit (ECALL)
+  if (rec.trap) {
+    state.exit_reason = ExitReason::Ecall;
+    state.graceful_exit = true;
+    return true;
+  }
+
+  return false;
+}
+
+// A crash check fired. With DIFF_MODE=digest the commits since the last
+// checkpoint are still unchecked, and they retired first: a divergence among
+// them is the finding detailed mode would have reported, so it replaces the
+// crash just written.
+static bool report_after_window(const ExecutionContext& ctx, InputView input) {
+  const std::string later = ctx.logger.lastCrashBase();
+  if (ctx.diff_checker.flush(ctx.logger, input)) {
+    ctx.logger.discardCrash(later);
+  }
+  return true;
+}
+
+bool run_execution_loop(const ExecutionContext& ctx, InputView input,
+                        ExecutionState& state) {
+  CpuIface* cpu = ctx.cpu;
+  const HarnessConfig& cfg = ctx.cfg;
+  CrashLogger& logger = ctx.logger;
+  GoldenModel& golden = ctx.golden;
+  DifferentialChecker& diff_checker = ctx.diff_checker;
+  const bool tohost_on_bus = cpu->handles_tohost();
+
+  // state.cyc is the index of the cycle being examined, as if the DUT were
+  // stepped one cycle at a time: it stays on the event cycle when the loop
+  // breaks and reaches cfg.max_cycles when the budget runs out.
+  while (state.cyc < cfg.max_cycles && !cpu->got_finish()) {
+    handle_signal_crash(logger, ctx.tracer, cpu, state.cyc, input);
+
+    CommitRec rec;
+    unsigned stepped = 0;
+    CommitStatus status = cpu->run_until_commit(rec, cfg.max_cycles - state.cyc, stepped);
+
+    if (status == CommitStatus::Budget) {
+      state.cyc += stepped;
+      break;
+    }
+    state.cyc += stepped - 1;
+
+    if (status == CommitStatus::Finish) {
+      state.exit_reason = ExitReason::Finish;
+      state.graceful_exit = true;
+      break;
+    }
+
+    // tohost store seen on the bus; the store itself has not retired yet
+    if (status == CommitStatus::DeviceExit) {
+      state.exit_reason = ExitReason::Tohost;
+      state.graceful_exit = true;
+      break;
+    }
+
+    // Trap on a cycle without a retired instruction
+    if (status == CommitStatus::Trap) {
+      return crash_detection::check_trap(rec, logger, state.cyc, input) &&
+             report_after_window(ctx, input);
+    }
+
+    // Process committed instruction
+    ++state.retired;
+    ctx.tracer.write(rec);
+
+    // Check PC stagnation
+    if (crash_detection::check_pc_stagnation(rec, logger, state.cyc, input,
+                                             cfg.pc_stagnation_limit, state.last_progress_pc,
+                                             state.last_progress_valid, state.stagnation_count)) {
+      return report_after_window(ctx, input);
+    }
+
+    // Check exit conditions
+    if (check_exit_conditions(rec, cfg, tohost_on_bus, state)) {
+      break;
+    }
+
+    // Update DUT state
+    diff_checker.update_dut_state(rec);
+    diff_checker.update_dut_csrs(rec);
+
+    // Golden model differential checking
+    if (golden.is_ready()) {
+      CommitRec gold_rec;
+      if (golden.next_commit(gold_rec)) {
+        diff_checker.update_golden_state(gold_rec);
+        if (diff_checker.check_divergence(rec, gold_rec, logger, state.cyc, input)) {
+          return true;
+        }
+      } else if (cfg.stop_on_spike_done && golden.finished()) {
+        state.exit_reason = ExitReason::SpikeDone;
+        state.graceful_exit = true;
+        break;
+      }
+    }
+
+    // Perform retire-time crash checks
+    if (crash_detection::check_x0_write(rec, logger, state.cyc, input) ||
+        crash_detection::check_pc_misaligned(rec, logger, state.cyc, input) ||
+        crash_detection::check_mem_align_store(rec, logger, state.cyc, input) ||
+        crash_detection::check_mem_align_load(rec, logger, state.cyc, input) ||
+        crash_detection::check_trap(rec, logger, state.cyc, input)) {
+      return report_after_window(ctx, input);
+    }
+
+    ++state.cyc;
+  }
+  return false;
+}
+
+// TRACE_MODE=ring: attach both flight recorders to the crash just written
+static void dump_trace_rings(const ExecutionContext& ctx) {
+  const std::string& base = ctx.logger.lastCrashBase();
+  if (base.empty()) return;
+  ctx.tracer.dump_ring(base + ".dut.trace");
+  ctx.golden.dump_trace(base + ".golden.trace");
+}
+
+ExecOutcome run_one_input(const ExecutionContext& ctx, InputView input) {
+  CpuIface* cpu = ctx.cpu;
+  const HarnessConfig& cfg = ctx.cfg;
+  GoldenModel& golden = ctx.golden;
+
+  // Setup golden model first: with GOLDEN_ASYNC=1 the ELF build and Spike
+  // launch run on the golden thread while the DUT is re-armed below
+  golden.initialize(input, cfg.trace_dir.c_str());
+
+  // Re-arm DUT and checkers for this input. Only the first input pays for
+  // the reset sequence; later ones restore the post-reset snapshot.
+  if (!cpu->restore_state()) {
+    cpu->reset();
+    cpu->save_state();
+  }
+  cpu->load_input(input.data(), input.size());
+  ctx.diff_checker.reset();
+  ctx.logger.clearLastCrash();
+
+  // Truncates the previous input's trace so the file always matches the last run
+  if (ctx.trace_enabled) {
+    ctx.tracer.open(cfg.trace_dir);
+  }
+
+  // Run execution
+  ExecutionState state = {};
+  state.exit_reason = ExitReason::None;
+  state.graceful_exit = false;
+  state.stagnation_count = 0;
+  state.last_progress_valid = false;
+  state.retired = 0;
+
+  bool crashed = run_execution_loop(ctx, input, state);
+  golden.stop();
+  ctx.tracer.flush();
+  // DIFF_MODE=digest: the commits since the last checkpoint are still unchecked
+  if (!crashed) {
+    crashed = ctx.diff_checker.flush(ctx.logger, input);
+  }
+
+  // MEM_DIGEST: stores that retired alike may still have hit different memory
+  if (!crashed && state.graceful_exit && golden.has_store_data()) {
+    crashed = ctx.diff_checker.check_memory_image(cpu->write_digest(), ctx.logger, state.cyc, input);
+  }
+
+  if (crashed) {
+    golden.dump_spike_log("crash");
+    dump_trace_rings(ctx);
+    return ExecOutcome::Crash;
+  }
+
+  // Handle termination
+  if (state.graceful_exit) {
+    hwfuzz::debug::logInfo("[HARNESS] Graceful termination after %u cycles (reason=%s).\n",
+                           state.cyc, exit_reason_text(state.exit_reason));
+    if (state.retired > 0) {
+      hwfuzz::debug::logDebug("[HARNESS] Retired %u instructions, CPI %.3f\n",
+                             state.retired, (double)state.cyc / state.retired);
+    }
+    return ExecOutcome::Graceful;
+  }
+
+  // Check for timeout
+  if (crash_detection::check_timeout(state.cyc, cfg.max_cycles, cpu, ctx.logger, input)) {
+    golden.dump_spike_log("timeout");
+    dump_trace_rings(ctx);
+    return ExecOutcome::Timeout;
+  }
+
+  return ExecOutcome::Graceful;
+}
+
+} // namespace execution
@@ -0,0 +1,305 @@
+#include "GoldenCache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ============================================================================
+// Commit stream encoding
+// ============================================================================
+//
+// One flags byte, the instruction word, then only the fields the flags say
+// are present. pc_r is predicted as the previous pc_w and pc_w as pc_r + 4,
+// so straight-line ALU code costs flags + insn + rd = 13 bytes instead of
+// sizeof(CommitRec).
+
+namespace {
+
+enum : uint8_t {
+  kPcR   = 1 << 0,  // pc_r differs from the previous pc_w
+  kPcW   = 1 << 1,  // pc_w differs from pc_r + 4
+  kRd    = 1 << 2,  // rd_addr, rd_wdata
+  kMem   = 1 << 3,  // mem_addr, masks, data, load/store flags
+  kTrap  = 1 << 4,
+  kCsr   = 1 << 5,  // mcycle/minstret masks and values
+};
+
+inline void put32(std::vector<uint8_t>& out, uint32_t v) {
+  uint8_t b[4];
+  std::memcpy(b, &v, 4);
+  out.insert(out.end(), b, b + 4);
+}
+
+inline void put64(std::vector<uint8_t>& out, uint64_t v) {
+  uint8_t b[8];
+  std::memcpy(b, &v, 8);
+  out.insert(out.end(), b, b + 8);
+}
+
+} // namespace
+
+void CommitEncoder::append(const CommitRec& rec, std::vector<uint8_t>& out) {
+  uint8_t flags = 0;
+  if (rec.pc_r != prev_pc_) flags |= kPcR;
+  if (rec.pc_w != rec.pc_r + 4) flags |= kPcW;
+  if (rec.rd_addr || rec.rd_wdata) flags |= kRd;
+  if (rec.mem_addr || rec.mem_rmask || rec.mem_wmask || rec.mem_wdata ||
+      rec.mem_rdata || rec.mem_is_load || rec.mem_is_store) {
+    flags |= kMem;
+  }
+  if (rec.trap) flags |= kTrap;
+  if (rec.csr_mcycle_wmask || rec.csr_mcycle_wdata ||
+      rec.csr_minstret_wmask || rec.csr_minstret_wdata) {
+    flags |= kCsr;
+  }
+
+  out.push_back(flags);
+  put32(out, rec.insn);
+  if (flags & kPcR) put32(out, rec.pc_r);
+  if (flags & kPcW) put32(out, rec.pc_w);
+  if (flags & kRd) {
+    put32(out, rec.rd_addr);
+    put32(out, rec.rd_wdata);
+  }
+  if (flags & kMem) {
+    put32(out, rec.mem_addr);
+    put32(out, rec.mem_rmask);
+    put32(out, rec.mem_wmask);
+    put32(out, rec.mem_wdata);
+    put32(out, rec.mem_rdata);
+    out.push_back(rec.mem_is_load);
+    out.push_back(rec.mem_is_store);
+  }
+  if (flags & kTrap) put32(out, rec.trap);
+  if (flags & kCsr) {
+    put64(out, rec.csr_mcycle_wmask);
+    put64(out, rec.csr_mcycle_wdata);
+    put64(out, rec.csr_minstret_wmask);
+    put64(out, rec.csr_minstret_wdata);
+  }
+  prev_pc_ = rec.pc_w;
+}
+
+bool CommitDecoder::next(CommitRec& rec) {
+  auto get = [this](void* dst, size_t n) {
+    if ((size_t)(end_ - p_) < n) return false;
+    std::memcpy(dst, p_, n);
+    p_ += n;
+    return true;
+  };
+
+  uint8_t flags;
+  if (!get(&flags, 1)) return false;
+  rec = CommitRec();
+  bool ok = get(&rec.insn, 4);
+  rec.pc_r = prev_pc_;
+  if (flags & kPcR) ok = ok && get(&rec.pc_r, 4);
+  rec.pc_w = rec.pc_r + 4;
+  if (flags & kPcW) ok = ok && get(&rec.pc_w, 4);
+  if (flags & kRd) ok = ok && get(&rec.rd_addr, 4) && get(&rec.rd_wdata, 4);
+  if (flags & kMem) {
+    ok = ok && get(&rec.mem_addr, 4) && get(&rec.mem_rmask, 4) &&
+         get(&rec.mem_wmask, 4) && get(&rec.mem_wdata, 4) &&
+         get(&rec.mem_rdata, 4) && get(&rec.mem_is_load, 1) &&
+         get(&rec.mem_is_store, 1);
+  }
+  if (flags & kTrap) ok = ok && get(&rec.trap, 4);
+  if (flags & kCsr) {
+    ok = ok && get(&rec.csr_mcycle_wmask, 8) && get(&rec.csr_mcycle_wdata, 8) &&
+         get(&rec.csr_minstret_wmask, 8) && get(&rec.csr_minstret_wdata, 8);
+  }
+  if (!ok) {
+    p_ = end_;
+    return false;
+  }
+  prev_pc_ = rec.pc_w;
+  return true;
+}
+
+// ============================================================================
+// Shared file layout
+// ============================================================================
+
+namespace {
+
+constexpr uint64_t kMagic = 0x4548434143474857ull;  // "HWGCACHE"
+constexpr uint32_t kVersion = 1;
+constexpr size_t kMinSize = 1 << 20;
+
+// Entry header in the data area; the payload follows it
+struct EntryHeader {
+  uint64_t key;
+  uint64_t check;
+  uint64_t pos;        // Absolute log position; detects a slot pointing at reused space
+  uint32_t length;     // Payload bytes
+  uint32_t commits;
+  uint32_t flags;
+  uint32_t sum;        // Low half of hash(payload)
+};
+
+constexpr uint64_t align8(uint64_t v) { return (v + 7) & ~uint64_t(7); }
+
+inline uint64_t mix(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+} // namespace
+
+struct GoldenCache::Header {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t slot_count;       // Power of two
+  uint64_t data_offset;      // From the start of the file
+  uint64_t data_size;        // Bytes in the ring log
+  alignas(64) std::atomic<uint64_t> cursor;  // Bytes ever reserved in the log
+
+  std::atomic<uint64_t>* slots() {
+    return reinterpret_cast<std::atomic<uint64_t>*>(this + 1);
+  }
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "GoldenCache needs address-free 64-bit atomics");
+
+uint64_t GoldenCache::hash(const void* data, size_t len, uint64_t seed) {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  uint64_t h = mix(seed ^ (len * 0x9e3779b97f4a7c15ull));
+  while (len >= 8) {
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    h = mix(h ^ v) + 0x9e3779b97f4a7c15ull;
+    p += 8;
+    len -= 8;
+  }
+  uint64_t tail = 0;
+  if (len) std::memcpy(&tail, p, len);
+  return mix(h ^ tail ^ ((uint64_t)len << 56));
+}
+
+bool GoldenCache::open(const std::string& path, size_t size_bytes) {
+  close();
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+  if (fd < 0) return false;
+
+  // The lock only serializes first-time initialization between processes;
+  // lookups and inserts never take it
+  ::flock(fd, LOCK_EX);
+  struct stat st;
+  bool ok = ::fstat(fd, &st) == 0;
+  // magic, version/slot_count, data_offset, data_size
+  uint64_t existing[4] = {};
+  bool valid = ok && (size_t)st.st_size >= kMinSize &&
+               ::pread(fd, existing, sizeof(existing), 0) == (ssize_t)sizeof(existing) &&
+               existing[0] == kMagic && (uint32_t)existing[1] == kVersion &&
+               existing[2] + existing[3] == (uint64_t)st.st_size;
+  size_t size = valid ? (size_t)st.st_size : std::max(size_bytes, kMinSize);
+  if (ok && !valid) ok = ::ftruncate(fd, 0) == 0 && ::ftruncate(fd, (off_t)size) == 0;
+
+  void* map = MAP_FAILED;
+  if (ok) map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (map != MAP_FAILED && !valid) {
+    // One slot per 4 KiB of log: sized for typical fuzz inputs
+    uint32_t slots = 1024;
+    while ((uint64_t)slots * 4096 < size && slots < (1u << 24)) slots <<= 1;
+    Header* h = static_cast<Header*>(map);
+    h->version = kVersion;
+    h->slot_count = slots;
+    h->data_offset = align8(sizeof(Header) + (uint64_t)slots * sizeof(uint64_t));
+    h->data_size = size - h->data_offset;
+    h->cursor.store(0, std::memory_order_relaxed);
+    // ftruncate zero-filled the slots; the magic goes last
+    std::atomic_thread_fence(std::memory_order_release);
+    h->magic = kMagic;
+    ::msync(map, sizeof(Header), MS_ASYNC);
+  }
+  ::flock(fd, LOCK_UN);
+  ::close(fd);
+  if (map == MAP_FAILED) return false;
+
+  base_ = static_cast<uint8_t*>(map);
+  map_size_ = size;
+  header_ = static_cast<Header*>(map);
+  return true;
+}
+
+void GoldenCache::close() {
+  if (base_) ::munmap(base_, map_size_);
+  base_ = nullptr;
+  header_ = nullptr;
+  map_size_ = 0;
+}
+
+// ============================================================================
+// Lookup / insert
+// ============================================================================
+
+bool GoldenCache::lookup(uint64_t key, uint64_t check, Entry& out) const {
+  if (!header_) return false;
+  Header* h = header_;
+  const uint64_t ref = h->slots()[key & (h->slot_count - 1)].load(std::memory_order_acquire);
+  if (ref == 0) return false;
+  const uint64_t pos = ref - 1;
+  const uint64_t size = h->data_size;
+  if (h->cursor.load(std::memory_order_acquire) - pos > size) return false;  // Evicted
+
+  const uint8_t* data = base_ + h->data_offset;
+  const uint64_t off = pos % size;
+  if (off + sizeof(EntryHeader) > size) return false;
+  EntryHeader eh;
+  std::memcpy(&eh, data + off, sizeof(eh));
+  if (eh.key != key || eh.check != check || eh.pos != pos ||
+      off + sizeof(EntryHeader) + eh.length > size) {
+    return false;
+  }
+  out.payload.resize(eh.length);
+  std::memcpy(out.payload.data(), data + off + sizeof(EntryHeader), eh.length);
+
+  // A writer that lapped the log while we copied may have torn the entry
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (h->cursor.load(std::memory_order_relaxed) - pos > size) return false;
+  if ((uint32_t)hash(out.payload.data(), eh.length, key) != eh.sum) return false;
+  out.commits = eh.commits;
+  out.flags = eh.flags;
+  return true;
+}
+
+bool GoldenCache::insert(uint64_t key, uint64_t check, const Entry& entry) {
+  if (!header_) return false;
+  Header* h = header_;
+  const uint64_t size = h->data_size;
+  const uint64_t total = align8(sizeof(EntryHeader) + entry.payload.size());
+  if (total > size / 8) return false;
+
+  // Reserve space; a reservation straddling the end of the log is skipped
+  uint64_t pos;
+  for (;;) {
+    pos = h->cursor.fetch_add(total, std::memory_order_acq_rel);
+    if (pos % size + total <= size) break;
+  }
+
+  EntryHeader eh;
+  eh.key = key;
+  eh.check = check;
+  eh.pos = pos;
+  eh.length = (uint32_t)entry.payload.size();
+  eh.commits = entry.commits;
+  eh.flags = entry.flags;
+  eh.sum = (uint32_t)hash(entry.payload.data(), entry.payload.size(), key);
+  uint8_t* dst = base_ + h->data_offset + pos % size;
+  std::memcpy(dst, &eh, sizeof(eh));
+  std::memcpy(dst + sizeof(eh), entry.payload.data(), entry.payload.size());
+
+  h->slots()[key & (h->slot_count - 1)].store(pos + 1, std::memory_order_release);
+  return true;
+}
@@ -1,17 +1,77 @@
 #include "GoldenModel.hpp"
+#include "MemoryLayout.hpp"
 #include "SpikeHelpers.hpp"
+#include "SpscRing.hpp"
 #include <hwfuzz/Debug.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
 #include <cstdlib>
+#include <mutex>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+// GOLDEN_CACHE: a run whose DUT side stopped early is finished by pulling at
+// most this many more golden commits in stop(); longer tails are not cached
+static constexpr unsigned kCacheDrainLimit = 4096;
+// Encoded streams above this size are not worth a cache slot
+static constexpr size_t kCacheMaxEntry = 1 << 20;
+
+// File name of an input's trace under GOLDEN_RECORD / a GOLDEN_REPLAY directory
+static std::string input_trace_name(InputView input) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.trace",
+                (unsigned long long)GoldenCache::hash(input.data(), input.size(), 0));
+  return name;
+}
+
+// GOLDEN_ASYNC=1: one golden thread per GoldenModel runs the backend and
+// feeds parsed commits to the DUT thread through the ring
+struct GoldenModel::AsyncState {
+  SpscRing<CommitRec, 4096> ring;
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool job_pending = false;   // Guarded by mutex
+  bool busy = false;          // Guarded by mutex
+  bool quit = false;          // Guarded by mutex
+  InputView input;                // Valid until stop(), which run_one_input() calls
+  std::atomic<bool> cancel{false};
+  std::atomic<bool> done{false};  // Producer pushed its last commit for this run
+  bool started = false;           // start_backend() succeeded, published by done
+  bool finished = false;          // finished_backend(), published by done
+  bool complete = false;          // pull_complete_ of the run, published by done
+};
 
 GoldenModel::GoldenModel() 
-  : golden_ready_(false), trace_enabled_(false), golden_mode_("live") {
+  : golden_ready_(false), trace_enabled_(false), golden_mode_("live"),
+    configured_(false), trace_requested_(true), backend_(Backend::Spike),
+    toolchain_elf_(false), replay_pos_(0), elf_fd_(-1), elf_load_addr_(MemoryLayout::kResetVector),
+    elf_ram_base_(MemoryLayout::kRamBase), load_base_(MemoryLayout::kResetVector),
+    stack_addr_(MemoryLayout::kStackAddr), max_image_(MemoryLayout().image_size()),
+    max_commits_(0), stagnation_limit_(0), commits_(0), same_pc_count_(0), last_pc_(0),
+    pull_complete_(false),
+    async_requested_(false), cache_seed_(0), cache_state_(CacheState::Off),
+    cache_key_(0), cache_check_(0), cache_complete_(false) {
 }
 
 GoldenModel::~GoldenModel() {
   stop();
+  if (async_) {
+    {
+      std::lock_guard<std::mutex> lock(async_->mutex);
+      async_->quit = true;
+    }
+    async_->cv.notify_one();
+    async_->thread.join();
+  }
+  if (elf_fd_ >= 0) {
+    ::close(elf_fd_);
+  }
 }
 
-bool GoldenModel::initialize(const std::vector<unsigned char>& input, const char* trace_dir) {
+void GoldenModel::configure() {
   // Read configuration from environment
   const char* golden_mode_env = std::getenv("GOLDEN_MODE");
   const char* spike_env = std::getenv("SPIKE_BIN");
@@ -24,82 +84,350 @@ bool GoldenModel::initialize(const std::vector<unsigned char>& input, const char
     golden_mode_ = std::string(golden_mode_env);
   }
 
+  spike_bin_ = spike_env && *spike_env ? std::string(spike_env) : "";
+  spike_isa_ = spike_isa_env && *spike_isa_env ? std::string(spike_isa_env) : "rv32imc";
+  pk_bin_ = pk_env && *pk_env ? std::string(pk_env) : "";
+  spike_log_path_ = spike_log_env && *spike_log_env ? std::string(spike_log_env) : "";
+  const char* elf_builder_env = std::getenv("SPIKE_ELF_BUILDER");
+  toolchain_elf_ = elf_builder_env && std::string(elf_builder_env) == "toolchain";
+  const char* replay_env = std::getenv("GOLDEN_REPLAY");
+  replay_path_ = replay_env && *replay_env ? std::string(replay_env) : "";
+  const char* record_env = std::getenv("GOLDEN_RECORD");
+  record_dir_ = record_env && *record_env ? std::string(record_env) : "";
+
+  trace_requested_ = true;
+  if (trace_mode_env && (std::string(trace_mode_env) == "off" || std::string(trace_mode_env) == "0")) {
+    trace_requested_ = false;
+  }
+  if (trace_mode_env && std::string(trace_mode_env) == "ring") {
+    golden_tracer_.set_ring(env_addr("TRACE_RING", 1024));
+  }
+
+  // GOLDEN_MODE=server used to run the same ISS behind a pipe; builtin is that
+  // model without the round trip
+  if (golden_mode_ == "server") {
+    hwfuzz::debug::logWarn("[GOLDEN] GOLDEN_MODE=server was removed; using builtin\n");
+    golden_mode_ = "builtin";
+  }
+  // "live" runs Spike, "builtin" the ISS; normalise unknown values once here
+  if (golden_mode_ != "live" && golden_mode_ != "builtin" &&
+      golden_mode_ != "off" && golden_mode_ != "none" && golden_mode_ != "0" &&
+      golden_mode_ != "batch" && golden_mode_ != "replay") {
+    hwfuzz::debug::logWarn("[GOLDEN] Unknown GOLDEN_MODE=%s, defaulting to live\n", golden_mode_.c_str());
+    golden_mode_ = "live";
+  }
+
+  // Same memory map as CpuPicoRV32: image from the reset vector to the end of RAM
+  const MemoryLayout layout = MemoryLayout::from_env();
+  load_base_ = layout.reset_vector;
+  max_image_ = layout.image_size();
+  stack_addr_ = layout.stack_addr;
+  elf_load_addr_ = layout.reset_vector;
+  elf_ram_base_ = layout.ram_base;
+  if (golden_mode_ == "batch") {
+    hwfuzz::debug::logInfo("[GOLDEN] GOLDEN_MODE=batch: no golden model in the fuzzer; "
+                           "run batch_picorv32 --watch for the differential checks\n");
+  }
+  backend_ = golden_mode_ == "builtin" ? Backend::Builtin
+           : golden_mode_ == "replay"  ? Backend::Replay
+                                       : Backend::Spike;
+  if (backend_ == Backend::Replay) {
+    hwfuzz::debug::logInfo("[GOLDEN] Replaying recorded golden traces from %s\n",
+                           replay_path_.empty() ? "<GOLDEN_REPLAY unset>" : replay_path_.c_str());
+  } else if (!record_dir_.empty()) {
+    utils::ensure_dir(record_dir_);
+    hwfuzz::debug::logInfo("[GOLDEN] Recording golden traces to %s\n", record_dir_.c_str());
+  }
+  if (backend_ == Backend::Builtin) {
+    hwfuzz::debug::logInfo("[GOLDEN] Using built-in RV32IM model (GOLDEN_MODE=builtin)\n");
+    iss_.reserve(load_base_, (uint32_t)max_image_);
+    if (const char* th = std::getenv("TOHOST_ADDR")) {
+      if (*th) iss_.set_tohost((uint32_t)std::strtoul(th, nullptr, 0));
+    }
+  }
+
+  // Set log path; the raw log is kept in memory and written on crash,
+  // divergence or for every SPIKE_LOG_SAMPLE-th run
+  if (!spike_log_path_.empty()) {
+    spike_.set_log_path(spike_log_path_);
+    spike_.set_log_ring(env_addr("SPIKE_LOG_RING", 256), env_addr("SPIKE_LOG_SAMPLE", 0));
+  }
+  const int kill_timeout_ms = (int)env_addr("GOLDEN_KILL_TIMEOUT_MS", 100);
+  spike_.set_kill_timeout(kill_timeout_ms);
+  // A silent Spike is given ten kill timeouts (1 s by default) to print again
+  spike_.set_stall_timeout((int)env_addr("GOLDEN_STALL_TIMEOUT_MS", 10 * kill_timeout_ms));
+  // The thread itself starts on first use, after the AFL++ fork point
+  async_requested_ = env_addr("GOLDEN_ASYNC", 0) != 0;
+
+  // Mapped before the AFL++ fork point; MAP_SHARED survives fork()
+  const char* cache_env = std::getenv("GOLDEN_CACHE");
+  const bool golden_off = golden_mode_ == "off" || golden_mode_ == "none" || golden_mode_ == "0" ||
+                          golden_mode_ == "batch" || golden_mode_ == "replay";
+  if (cache_env && *cache_env && !golden_off && !cache_.is_open()) {
+    const size_t mb = env_addr("GOLDEN_CACHE_MB", 256);
+    if (cache_.open(cache_env, mb << 20)) {
+      hwfuzz::debug::logInfo("[GOLDEN] Golden trace cache: %s (%zu MB)\n", cache_env, mb);
+    } else {
+      hwfuzz::debug::logWarn("[GOLDEN] Cannot map GOLDEN_CACHE=%s; running without it\n", cache_env);
+    }
+  }
+  update_cache_seed();
+
+  configured_ = true;
+}
+
+bool GoldenModel::initialize(InputView input, const char* trace_dir) {
+  // Tear down the previous input's Spike run (persistent mode reuses this object)
+  stop();
+  spike_.discard_log();
+  trace_enabled_ = false;
+
+  if (!configured_) {
+    configure();
+  }
+
   // Check if golden model should be disabled
   if (golden_mode_ == "off" || golden_mode_ == "none" || golden_mode_ == "0") {
     hwfuzz::debug::logInfo("[GOLDEN] Golden model disabled (GOLDEN_MODE=%s)\n", golden_mode_.c_str());
     return false;
   }
 
-  if (golden_mode_ == "batch" || golden_mode_ == "replay") {
-    hwfuzz::debug::logInfo("[GOLDEN] GOLDEN_MODE=%s; external replay/tools should be used.\n", golden_mode_.c_str());
+  if (golden_mode_ == "batch") {
+    // DUT-only fuzzing; batch_picorv32 --watch does the golden checks
     return false;
   }
 
-  // Only proceed for "live" mode
-  if (golden_mode_ != "live") {
-    hwfuzz::debug::logWarn("[GOLDEN] Unknown GOLDEN_MODE=%s, defaulting to live\n", golden_mode_.c_str());
-    golden_mode_ = "live";
+  if (cache_.is_open()) {
+    cache_key_ = GoldenCache::hash(input.data(), input.size(), cache_seed_);
+    cache_check_ = GoldenCache::hash(input.data(), input.size(), ~cache_seed_);
+    if (cache_.lookup(cache_key_, cache_check_, cache_entry_)) {
+      hwfuzz::debug::logDebug("[GOLDEN] Cache hit: %u commits\n", cache_entry_.commits);
+      cache_decoder_.reset(cache_entry_.payload.data(), cache_entry_.payload.size());
+      cache_state_ = CacheState::Replay;
+    }
   }
 
-  if (!spike_env || !*spike_env) {
-    hwfuzz::debug::logInfo("[GOLDEN] SPIKE_BIN not set; golden model disabled\n");
+  if (cache_state_ == CacheState::Replay) {
+    // No backend for this input
+  } else if (async_requested_) {
+    // Backend start-up and the DUT reset now overlap; a failed start shows
+    // up as a run without commits
+    start_async(input);
+  } else if (!start_backend(input)) {
     return false;
   }
 
-  std::string spike_bin(spike_env);
-  std::string spike_isa = spike_isa_env && *spike_isa_env ? std::string(spike_isa_env) : "rv32imc";
-  std::string pk_bin = pk_env && *pk_env ? std::string(pk_env) : "";
+  const bool recording = cache_.is_open() || (!record_dir_.empty() && backend_ != Backend::Replay);
+  if (recording && cache_state_ == CacheState::Off) {
+    record_path_ = record_dir_.empty() ? "" : record_dir_ + "/" + input_trace_name(input);
+    cache_state_ = CacheState::Record;
+    cache_complete_ = false;
+    cache_entry_.payload.clear();
+    cache_entry_.commits = 0;
+    cache_encoder_.reset();
+  }
+
+  golden_ready_ = true;
+
+  // Setup golden trace if enabled
+  trace_enabled_ = trace_requested_;
+
+  if (trace_enabled_) {
+    hwfuzz::debug::logInfo("[GOLDEN] Opening golden trace in %s\n", trace_dir);
+    golden_tracer_.open_with_basename(trace_dir, "golden.trace");
+  }
+
+  return true;
+}
+
+bool GoldenModel::start_backend(InputView input) {
+  commits_ = 0;
+  same_pc_count_ = 0;
+  pull_complete_ = false;
+  switch (backend_) {
+    case Backend::Builtin: return start_builtin(input);
+    case Backend::Spike:   return start_spike(input);
+    case Backend::Replay:  return start_replay(input);
+  }
+  return false;
+}
 
-  // Set log path
-  if (spike_log_env && *spike_log_env) {
-    spike_.set_log_path(spike_log_env);
+bool GoldenModel::start_spike(InputView input) {
+  if (spike_bin_.empty()) {
+    hwfuzz::debug::logInfo("[GOLDEN] SPIKE_BIN not set; golden model disabled\n");
+    return false;
   }
 
-  // Build temporary ELF from input
-  tmp_elf_ = spike_helpers::build_spike_elf(input);
-  if (tmp_elf_.empty()) {
+  if (!build_elf(input)) {
     hwfuzz::debug::logError("[GOLDEN] Failed to build Spike ELF; disabling golden model\n");
     return false;
   }
 
   // Start Spike process
-  if (!spike_.start(spike_bin, tmp_elf_, spike_isa, pk_bin)) {
+  if (!spike_.start(spike_bin_, tmp_elf_, spike_isa_, pk_bin_)) {
     hwfuzz::debug::logError("[GOLDEN] Failed to start Spike.\n  Command: %s\n  ELF: %s\n", 
                             spike_.command().c_str(), tmp_elf_.c_str());
-    if (spike_log_env && *spike_log_env) {
-      hwfuzz::debug::logError("[GOLDEN]   See Spike log: %s\n", spike_log_env);
-      spike_helpers::print_log_tail(spike_log_env, 60);
+    if (!spike_log_path_.empty()) {
+      hwfuzz::debug::logError("[GOLDEN]   See Spike log: %s\n", spike_log_path_.c_str());
+      spike_helpers::print_log_tail(spike_log_path_.c_str(), 60);
     }
     return false;
   }
 
-  golden_ready_ = true;
   hwfuzz::debug::logInfo("[GOLDEN] Spike golden model started successfully\n");
+  return true;
+}
 
-  // Setup golden trace if enabled
-  trace_enabled_ = true;
-  if (trace_mode_env && (std::string(trace_mode_env) == "off" || std::string(trace_mode_env) == "0")) {
-    trace_enabled_ = false;
+bool GoldenModel::build_elf(InputView input) {
+  if (toolchain_elf_) {
+    tmp_elf_ = spike_helpers::build_spike_elf(input);
+    return !tmp_elf_.empty();
   }
 
-  if (trace_enabled_) {
-    hwfuzz::debug::logInfo("[GOLDEN] Opening golden trace in %s\n", trace_dir);
-    golden_tracer_.open_with_basename(trace_dir, "golden.trace");
+  // Opened lazily so each AFL++ child (and batch worker) gets its own file
+  if (elf_fd_ < 0) {
+    elf_fd_ = spike_helpers::open_elf_image(elf_fd_path_);
+    if (elf_fd_ < 0) return false;
+  }
+  if (!spike_helpers::write_elf_image(elf_fd_, input, elf_load_addr_, elf_ram_base_)) {
+    return false;
+  }
+  tmp_elf_ = elf_fd_path_;
+  return true;
+}
+
+bool GoldenModel::start_builtin(InputView input) {
+  // Same image the DUT executes: input bytes at the reset vector, truncated to RAM
+  iss_.reset(load_base_, stack_addr_);
+  iss_.load(load_base_, input.data(), input.size() > max_image_ ? max_image_ : input.size());
+  return true;
+}
+
+bool GoldenModel::start_replay(InputView input) {
+  if (replay_path_.empty()) {
+    hwfuzz::debug::logInfo("[GOLDEN] GOLDEN_REPLAY not set; golden model disabled\n");
+    return false;
+  }
+  struct stat st;
+  std::string path = replay_path_;
+  const bool per_input = ::stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+  if (per_input) {
+    path += "/" + input_trace_name(input);
+    if (::stat(path.c_str(), &st) != 0) {
+      hwfuzz::debug::logDebug("[GOLDEN] No recorded trace %s\n", path.c_str());
+      return false;
+    }
   }
 
+  // A single GOLDEN_REPLAY file serves every input: parse it once
+  const std::string id = path + ":" + std::to_string((long long)st.st_size) + ":" +
+                         std::to_string((long long)st.st_mtime);
+  if (id != replay_loaded_) {
+    replay_loaded_.clear();
+    if (!replay_trace_.load(path)) {
+      hwfuzz::debug::logWarn("[GOLDEN] Cannot replay %s: %s\n", path.c_str(),
+                             replay_trace_.error().c_str());
+      return false;
+    }
+    replay_loaded_ = id;
+  }
+  replay_pos_ = 0;
+  return true;
+}
+
+void GoldenModel::set_limits(unsigned max_commits, unsigned stagnation_limit) {
+  max_commits_ = max_commits;
+  stagnation_limit_ = stagnation_limit;
+  update_cache_seed();
+}
+
+bool GoldenModel::within_limits(const CommitRec& rec) {
+  if (++commits_ > max_commits_ && max_commits_) {
+    return false;
+  }
+  if (stagnation_limit_) {
+    if (commits_ > 1 && rec.pc_w == last_pc_) {
+      if (++same_pc_count_ > stagnation_limit_) return false;
+    } else {
+      last_pc_ = rec.pc_w;
+      same_pc_count_ = 0;
+    }
+  }
   return true;
 }
 
 bool GoldenModel::next_commit(CommitRec& rec) {
   if (!golden_ready_) return false;
 
+  const bool ok = cache_state_ == CacheState::Replay ? cache_decoder_.next(rec)
+                                                     : fetch_commit(rec);
+  if (!ok) {
+    golden_ready_ = false;
+    cache_complete_ = cache_state_ == CacheState::Record && fetch_complete();
+    return false;
+  }
+  if (cache_state_ == CacheState::Record) {
+    record_commit(rec);
+  }
+  write_trace(rec);
+  return true;
+}
+
+bool GoldenModel::fetch_commit(CommitRec& rec) {
+  if (!async_) {
+    return pull_commit(rec);
+  }
+  AsyncState& a = *async_;
+  for (unsigned spins = 0;; ++spins) {
+    if (a.ring.pop(rec)) return true;
+    if (a.done.load(std::memory_order_acquire)) {
+      return a.ring.pop(rec);  // Pushed just before done
+    }
+    if (spins >= 64) std::this_thread::yield();
+  }
+}
+
+bool GoldenModel::fetch_complete() const {
+  return async_ ? async_->complete : pull_complete_;
+}
+
+bool GoldenModel::pull_commit(CommitRec& rec) {
+  // The in-process backends are deterministic: any end is the run's end
+  if (backend_ == Backend::Replay) {
+    const std::vector<CommitRec>& commits = replay_trace_.commits();
+    if (replay_pos_ < commits.size() && within_limits(commits[replay_pos_])) {
+      rec = commits[replay_pos_++];
+      return true;
+    }
+    pull_complete_ = true;
+    return false;
+  }
+
+  if (builtin()) {
+    if (iss_.step(rec) && within_limits(rec)) return true;
+    pull_complete_ = true;
+    return false;
+  }
+
   if (spike_.next_commit(rec)) {
-    write_trace(rec);
-    return true;
+    if (within_limits(rec)) {
+      return true;
+    }
+    // Looping program: the DUT hits the same limit, so kill Spike now
+    hwfuzz::debug::logDebug("[GOLDEN] Spike run over budget after %u commits; killing it\n", commits_);
+    spike_.stop();
+    pull_complete_ = true;
+    return false;
   }
 
-  // Spike stopped producing commits
-  golden_ready_ = false;
+  // Spike stopped producing commits. Only its own end of the log (or a fatal
+  // trap, which the program causes) is the full run; a stall timeout, an
+  // interrupt or a read error depends on the machine and must not be cached.
+  pull_complete_ = spike_.reached_eof() || spike_.saw_fatal_trap();
+  if (async_ && async_->cancel.load(std::memory_order_relaxed)) {
+    pull_complete_ = false;
+    return false;  // Interrupted by stop(), not a Spike problem
+  }
 
   if (spike_.saw_fatal_trap()) {
     const std::string& trap = spike_.fatal_trap_summary();
@@ -115,15 +443,42 @@ bool GoldenModel::next_commit(CommitRec& rec) {
                            spike_.command().c_str(), tmp_elf_.c_str());
   }
 
-  const char* spike_log = std::getenv("SPIKE_LOG_FILE");
-  if (spike_log && *spike_log) {
-    hwfuzz::debug::logWarn("[GOLDEN]   See Spike log: %s\n", spike_log);
-    spike_helpers::print_log_tail(spike_log, 60);
+  if (!spike_log_path_.empty()) {
+    // The raw log is still in memory; it reaches the file if the run is reported
+    hwfuzz::debug::logDebug("[GOLDEN]   Spike log (on crash/divergence): %s\n",
+                            spike_log_path_.c_str());
   }
 
   return false;
 }
 
+void GoldenModel::dump_spike_log(const char* reason) {
+  if (backend_ == Backend::Spike && spike_.dump_log(reason)) {
+    hwfuzz::debug::logInfo("[GOLDEN] Spike log of this run appended to %s\n",
+                           spike_log_path_.c_str());
+  }
+}
+
+bool GoldenModel::finished() const {
+  if (cache_state_ == CacheState::Replay) {
+    return cache_entry_.flags & 1;
+  }
+  if (async_) {
+    return async_->done.load(std::memory_order_acquire) && async_->finished;
+  }
+  return finished_backend();
+}
+
+bool GoldenModel::finished_backend() const {
+  if (builtin()) {
+    return iss_.exited();
+  }
+  if (backend_ == Backend::Replay) {
+    return replay_pos_ == replay_trace_.commits().size() && replay_trace_.finished();
+  }
+  return spike_.has_status() && spike_.exited() && spike_.exit_code() == 0;
+}
+
 void GoldenModel::write_trace(const CommitRec& rec) {
   if (trace_enabled_) {
     golden_tracer_.write(rec);
@@ -131,12 +486,162 @@ void GoldenModel::write_trace(const CommitRec& rec) {
 }
 
 void GoldenModel::stop() {
-  if (golden_ready_) {
-    spike_.stop();
-    golden_ready_ = false;
+  if (cache_state_ == CacheState::Record) {
+    store_recorded_run();
   }
+  cache_state_ = CacheState::Off;
+  // The golden thread must let go of the backend before it is touched here
+  cancel_async();
+  spike_.stop();
+  golden_tracer_.flush();
+  golden_ready_ = false;
   if (!tmp_elf_.empty()) {
-    ::unlink(tmp_elf_.c_str());
+    if (toolchain_elf_) {
+      ::unlink(tmp_elf_.c_str());
+    }
     tmp_elf_.clear();
   }
 }
+
+// ============================================================================
+// Asynchronous Pipeline (GOLDEN_ASYNC=1)
+// ============================================================================
+
+void GoldenModel::start_async(InputView input) {
+  if (!async_) {
+    async_ = std::make_unique<AsyncState>();
+    async_->thread = std::thread(&GoldenModel::async_main, this);
+  }
+  // The worker is idle: initialize() called stop() first
+  AsyncState& a = *async_;
+  a.ring.clear();
+  a.input = input;
+  a.cancel.store(false);
+  a.done.store(false);
+  a.started = false;
+  a.finished = false;
+  a.complete = false;
+  {
+    std::lock_guard<std::mutex> lock(a.mutex);
+    a.job_pending = true;
+  }
+  a.cv.notify_one();
+}
+
+void GoldenModel::cancel_async() {
+  if (!async_) return;
+  AsyncState& a = *async_;
+  a.cancel.store(true);
+  // The worker polls cancel between commits; only a backend that can sleep
+  // inside pull_commit() also needs waking
+  switch (backend_) {
+    case Backend::Spike:
+      spike_.interrupt();  // Wakes a read blocked on Spike's pipe
+      break;
+    case Backend::Builtin:  // One ISS step per commit, never blocks
+    case Backend::Replay:   // Commits come from memory, never blocks
+      break;
+  }
+  std::unique_lock<std::mutex> lock(a.mutex);
+  a.cv.wait(lock, [&a] { return !a.busy && !a.job_pending; });
+}
+
+void GoldenModel::async_main() {
+  AsyncState& a = *async_;
+  std::unique_lock<std::mutex> lock(a.mutex);
+  for (;;) {
+    a.cv.wait(lock, [&a] { return a.job_pending || a.quit; });
+    if (a.quit) return;
+    a.job_pending = false;
+    a.busy = true;
+    lock.unlock();
+
+    // A cancel before Spike is spawned sends a wake-up the spawn discards,
+    // so cancel is checked again after start_backend()
+    const bool started = !a.cancel.load() && start_backend(a.input);
+    a.started = started;
+    CommitRec rec;
+    while (started && !a.cancel.load(std::memory_order_relaxed) && pull_commit(rec)) {
+      while (!a.ring.push(rec)) {
+        if (a.cancel.load(std::memory_order_relaxed)) break;
+        std::this_thread::yield();  // DUT is behind; let it catch up
+      }
+    }
+    a.finished = started && !a.cancel.load() && finished_backend();
+    a.complete = started && !a.cancel.load() && pull_complete_;
+    spike_.stop();
+    a.done.store(true, std::memory_order_release);
+
+    lock.lock();
+    a.busy = false;
+    a.cv.notify_all();
+  }
+}
+
+// ============================================================================
+// Golden Trace Cache (GOLDEN_CACHE)
+// ============================================================================
+
+void GoldenModel::update_cache_seed() {
+  // Anything that changes the commit stream of an input must be in here
+  std::string cfg = "v1|" + golden_mode_ + "|" + spike_isa_ + "|" + pk_bin_ + "|" +
+                    (toolchain_elf_ ? "toolchain" : "memory");
+  auto add_file = [&cfg](const std::string& path) {
+    struct stat st;
+    cfg += "|" + path;
+    if (!path.empty() && ::stat(path.c_str(), &st) == 0) {
+      cfg += ":" + std::to_string((long long)st.st_size) + ":" + std::to_string((long long)st.st_mtime);
+    }
+  };
+  add_file(spike_bin_);
+  add_file("/proc/self/exe");  // The built-in ISS lives in the harness itself
+  if (const char* ld = std::getenv("LINKER_SCRIPT")) add_file(ld);
+  const uint64_t nums[] = {load_base_, max_image_, stack_addr_, elf_load_addr_, elf_ram_base_,
+                           env_addr("TOHOST_ADDR", 0), max_commits_, stagnation_limit_,
+                           sizeof(CommitRec)};
+  cache_seed_ = GoldenCache::hash(cfg.data(), cfg.size(),
+                                  GoldenCache::hash(nums, sizeof(nums), 0));
+}
+
+void GoldenModel::record_commit(const CommitRec& rec) {
+  cache_encoder_.append(rec, cache_entry_.payload);
+  ++cache_entry_.commits;
+  if (cache_entry_.payload.size() > kCacheMaxEntry) {
+    cache_state_ = CacheState::Off;
+  }
+}
+
+void GoldenModel::store_recorded_run() {
+  // The DUT side may have stopped first (divergence, exit, limit): pull the
+  // rest of the golden stream so the entry serves any later consumer
+  CommitRec rec;
+  for (unsigned i = 0; golden_ready_ && !cache_complete_ && i < kCacheDrainLimit; ++i) {
+    if (!fetch_commit(rec)) {
+      cache_complete_ = fetch_complete();
+      break;
+    }
+    record_commit(rec);
+    if (cache_state_ != CacheState::Record) return;
+  }
+  const bool started = async_ ? async_->done.load(std::memory_order_acquire) && async_->started
+                              : true;
+  if (!cache_complete_ || !started) {
+    return;
+  }
+  cache_entry_.flags = finished() ? 1u : 0u;
+  if (cache_.is_open() && cache_.insert(cache_key_, cache_check_, cache_entry_)) {
+    hwfuzz::debug::logDebug("[GOLDEN] Cached %u commits (%zu bytes)\n",
+                            cache_entry_.commits, cache_entry_.payload.size());
+  }
+
+  if (!record_path_.empty()) {
+    std::vector<CommitRec> commits;
+    commits.reserve(cache_entry_.commits);
+    CommitDecoder decoder;
+    decoder.reset(cache_entry_.payload.data(), cache_entry_.payload.size());
+    while (decoder.next(rec)) commits.push_back(rec);
+    if (!TraceFile::save(record_path_, commits, cache_entry_.flags & 1)) {
+      hwfuzz::debug::logWarn("[GOLDEN] Cannot write %s\n", record_path_.c_str());
+    }
+  }
+}
@@ -5,6 +5,7 @@
 
 #include "HarnessConfig.hpp"
 #include <hwfuzz/Debug.hpp>
+#include <algorithm>
 #include <fstream>
 
 std::unordered_map<std::string, std::string> HarnessConfig::parse_conf_file(const std::string& conf_path) {
@@ -78,6 +79,15 @@ void HarnessConfig::loadconfig() {
     stop_on_spike_done = (config["STOP_ON_SPIKE_DONE"] == "true" );
     pc_stagnation_limit = std::stoul(config["PC_STAGNATION_LIMIT"]);
     max_program_words = std::stoul(config["MAX_PROGRAM_WORDS"]);
+    // Optional key: older harness.conf files keep the built-in default
+    if (!config["PERSISTENT_ITERS"].empty()) {
+      persistent_iters = std::stoul(config["PERSISTENT_ITERS"]);
+    }
+    if (config["DIFF_MODE"] == "digest") {
+      diff_checkpoint = config["DIFF_CHECKPOINT"].empty() ? 64 : std::stoul(config["DIFF_CHECKPOINT"]);
+      diff_checkpoint = std::max(1u, std::min(diff_checkpoint, 65536u));
+    }
+    mem_digest = config["MEM_DIGEST"] == "true";
 
     
     hwfuzz::debug::logInfo("tohost address: 0x%08x\n", tohost_addr);
@@ -85,5 +95,12 @@ void HarnessConfig::loadconfig() {
     hwfuzz::debug::logInfo("Max cycles: %u\n", max_cycles);
     hwfuzz::debug::logInfo("Max program words: %u\n", max_program_words);
     hwfuzz::debug::logInfo("PC stagnation limit: %u\n", pc_stagnation_limit);
+    hwfuzz::debug::logInfo("Persistent iterations: %u\n", persistent_iters);
     hwfuzz::debug::logInfo("Stop on Spike completion: %s\n", stop_on_spike_done ? "yes" : "no");
+    if (diff_checkpoint) {
+      hwfuzz::debug::logInfo("Divergence checks: digest every %u commits\n", diff_checkpoint);
+    } else {
+      hwfuzz::debug::logInfo("Divergence checks: detailed\n");
+    }
+    hwfuzz::debug::logInfo("Memory image digest: %s\n", mem_digest ? "yes" : "no");
 }
@@ -3,6 +3,7 @@
 #include "CpuIface.hpp"
 #include "CrashLogger.hpp"
 #include "CrashDetection.hpp"
+#include "Execution.hpp"
 #include "Trace.hpp"
 #include "GoldenModel.hpp"
 #include "DifferentialChecker.hpp"
@@ -11,32 +12,15 @@
 
 #include "verilated.h"
 #include <hwfuzz/Debug.hpp>
-#include <csignal>
 #include <vector>
 #include <string>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <chrono>
 #include <fcntl.h>
 #include <unistd.h>
 
-// ============================================================================
-// Signal Handling
-// ============================================================================
-
-static volatile sig_atomic_t g_sig = 0;
-static void sig_handler(int s) { g_sig = s; }
-
-static void install_signal_handlers() {
-  struct sigaction sa;
-  std::memset(&sa, 0, sizeof(sa));
-  sa.sa_handler = sig_handler;
-  sigaction(SIGSEGV, &sa, nullptr);
-  sigaction(SIGILL,  &sa, nullptr);
-  sigaction(SIGBUS,  &sa, nullptr);
-  sigaction(SIGABRT, &sa, nullptr);
-}
-
 // ============================================================================
 // Input Loading
 // ============================================================================
@@ -58,8 +42,7 @@ static void read_all_fd(int fd, std::vector<unsigned char>& out, size_t cap = 1
   }
 }
 
-static std::vector<unsigned char> load_input(int argc, char** argv) {
-  std::vector<unsigned char> input;
+static void load_input(int argc, char** argv, std::vector<unsigned char>& input) {
   if (argc > 1 && argv[1][0] != '-') {
     int fd = ::open(argv[1], O_RDONLY);
     if (fd >= 0) {
@@ -71,153 +54,70 @@ static std::vector<unsigned char> load_input(int argc, char** argv) {
   } else {
     read_all_fd(STDIN_FILENO, input);
   }
-  return input;
 }
 
-// ============================================================================
-// Trace Setup
-// ============================================================================
+// AFL++ shared-memory testcase delivery. afl-clang-fast++ defines the
+// __AFL_FUZZ_* macros; __AFL_FUZZ_INIT() also tells afl-fuzz to use it.
+#ifdef __AFL_FUZZ_TESTCASE_LEN
+__AFL_FUZZ_INIT();
+#endif
 
-static TraceWriter setup_trace(const HarnessConfig& cfg) {
-  TraceWriter tracer;
-  const char* trace_mode_env = std::getenv("TRACE_MODE");
-  
-  bool trace_enabled = true;
-  if (trace_mode_env && (std::string(trace_mode_env) == "off" || std::string(trace_mode_env) == "0")) {
-    trace_enabled = false;
-  }
-  
-  if (trace_enabled) {
-    tracer.open(cfg.trace_dir);
+/// Points @p data at the shared-memory testcase when afl-fuzz provides one.
+/// Returns false outside AFL++ (run_once.sh, replay_golden.sh), in which case
+/// the caller falls back to load_input() from a file or stdin.
+static bool shm_testcase(const unsigned char*& data, size_t& len) {
+#ifdef __AFL_FUZZ_TESTCASE_LEN
+  // Checked directly: __AFL_FUZZ_TESTCASE_LEN would otherwise read stdin
+  if (__afl_fuzz_ptr) {
+    len = __AFL_FUZZ_TESTCASE_LEN;
+    data = __AFL_FUZZ_TESTCASE_BUF;
+    return true;
   }
-  
-  return tracer;
+#endif
+  (void)data;
+  (void)len;
+  return false;
 }
 
 // ============================================================================
-// DUT Execution Loop
+// Persistent Mode
 // ============================================================================
 
-struct ExecutionState {
-  unsigned cyc;
-  ExitReason exit_reason;
-  bool graceful_exit;
-  uint32_t last_progress_pc;
-  bool last_progress_valid;
-  unsigned stagnation_count;
-};
-
-static void handle_signal_crash(CrashLogger& logger, CpuIface* cpu, unsigned cyc,
-                                const std::vector<unsigned char>& input) {
-  if (g_sig) {
-    uint32_t pc = cpu->rvfi_pc_rdata();
-    uint32_t insn = cpu->rvfi_insn();
-    logger.writeCrash(std::string("signal_") + std::to_string(g_sig), pc, insn, cyc, input);
-    _exit(126);
-  }
+// afl-clang-fast++ defines __AFL_HAVE_MANUAL_CONTROL and __AFL_LOOP(); any
+// other compiler (or a plain replay build) executes a single input.
+#ifdef __AFL_HAVE_MANUAL_CONTROL
+#define HARNESS_LOOP(n) __AFL_LOOP(n)
+#else
+static bool harness_loop_once(unsigned) {
+  static bool done = false;
+  if (done) return false;
+  done = true;
+  return true;
 }
+#define HARNESS_LOOP(n) harness_loop_once(n)
+#endif
 
-static bool check_exit_conditions(CpuIface* cpu, const CommitRec& rec, const HarnessConfig& cfg,
-                                   ExecutionState& state) {
-  // Check for PC stagnation (infinite loop detection)
-  if (cpu->rvfi_valid()) {
-    if (state.last_progress_valid && rec.pc_r == state.last_progress_pc) {
-      state.stagnation_count++;
-    } else {
-      state.last_progress_pc = rec.pc_r;
-      state.last_progress_valid = true;
-      state.stagnation_count = 0;
-    }
-  }
-
-  // Check tohost exit
-  if (cfg.use_tohost && (rec.mem_wmask & 0xF) != 0) {
-    if ((rec.mem_addr & ~0x3u) == (cfg.tohost_addr & ~0x3u)) {
-      state.exit_reason = ExitReason::Tohost;
-      state.graceful_exit = true;
-      return true;
-    }
-  }
+// ============================================================================
+// Trace Setup
+// ============================================================================
 
-  // Check trap-based exit (ECALL)
-  if (rec.trap) {
-    state.exit_reason = ExitReason::Ecall;
-    state.graceful_exit = true;
-    return true;
+// Read once at startup; TRACE_MODE does not change between inputs
+static bool trace_mode_enabled() {
+  const char* trace_mode_env = std::getenv("TRACE_MODE");
+  
+  bool trace_enabled = true;
+  if (trace_mode_env && (std::string(trace_mode_env) == "off" || std::string(trace_mode_env) == "0")) {
+    trace_enabled = false;
   }
-
-  return false;
+  return trace_enabled;
 }
 
-static void run_execution_loop(CpuIface* cpu, const HarnessConfig& cfg,
-                               const std::vector<unsigned char>& input,
-                               CrashLogger& logger, TraceWriter& tracer,
-                               GoldenModel& golden, DifferentialChecker& diff_checker,
-                               ExecutionState& state) {
-  for (; state.cyc < cfg.max_cycles && !cpu->got_finish(); ++state.cyc) {
-    handle_signal_crash(logger, cpu, state.cyc, input);
-
-    cpu->step();
-
-    if (cpu->got_finish()) {
-      state.exit_reason = ExitReason::Finish;
-      state.graceful_exit = true;
-      break;
-    }
-
-    // Process committed instruction
-    if (cpu->rvfi_valid()) {
-      CommitRec rec;
-      rec.pc_r = cpu->rvfi_pc_rdata();
-      rec.pc_w = cpu->rvfi_pc_wdata();
-      rec.insn = cpu->rvfi_insn();
-      rec.rd_addr = cpu->rvfi_rd_addr();
-      rec.rd_wdata = cpu->rvfi_rd_wdata();
-      rec.mem_addr = cpu->rvfi_mem_addr();
-      rec.mem_rmask = cpu->rvfi_mem_rmask();
-      rec.mem_wmask = cpu->rvfi_mem_wmask();
-      rec.trap = cpu->trap() ? 1u : 0u;
-      
-      tracer.write(rec);
-
-      // Check PC stagnation
-      if (crash_detection::check_pc_stagnation(cpu, logger, state.cyc, input,
-                                               cfg.pc_stagnation_limit, state.last_progress_pc,
-                                               state.last_progress_valid, state.stagnation_count)) {
-        std::abort();
-      }
-
-      // Check exit conditions
-      if (check_exit_conditions(cpu, rec, cfg, state)) {
-        break;
-      }
-
-      // Update DUT state
-      diff_checker.update_dut_state(rec);
-      diff_checker.update_dut_csrs(cpu);
-
-      // Golden model differential checking
-      if (golden.is_ready()) {
-        CommitRec gold_rec;
-        if (golden.next_commit(gold_rec)) {
-          diff_checker.update_golden_state(gold_rec);
-          diff_checker.check_divergence(rec, gold_rec, logger, state.cyc, input);
-        } else if (cfg.stop_on_spike_done && golden.spike().has_status() &&
-                   golden.spike().exited() && golden.spike().exit_code() == 0) {
-          state.exit_reason = ExitReason::SpikeDone;
-          state.graceful_exit = true;
-          break;
-        }
-      }
-    }
-
-    // Perform retire-time crash checks
-    if (crash_detection::check_x0_write(cpu, logger, state.cyc, input)) std::abort();
-    if (crash_detection::check_pc_misaligned(cpu, logger, state.cyc, input)) std::abort();
-    if (crash_detection::check_mem_align_store(cpu, logger, state.cyc, input)) std::abort();
-    if (crash_detection::check_mem_align_load(cpu, logger, state.cyc, input)) std::abort();
-    if (crash_detection::check_trap(cpu, logger, state.cyc, input)) std::abort();
-  }
+// TRACE_MODE=ring: commits kept per side, 0 when traces go to disk every run
+static size_t trace_ring_records() {
+  const char* trace_mode_env = std::getenv("TRACE_MODE");
+  if (!trace_mode_env || std::string(trace_mode_env) != "ring") return 0;
+  const char* ring_env = std::getenv("TRACE_RING");
+  return ring_env && *ring_env ? std::strtoul(ring_env, nullptr, 0) : 1024;
 }
 
 // ============================================================================
@@ -226,9 +126,25 @@ static void run_execution_loop(CpuIface* cpu, const HarnessConfig& cfg,
 
 extern "C" CpuIface* make_cpu();
 
+// afl-clang-fast++ defines __AFL_INIT() when deferred forkserver support is
+// available; without it the forkserver starts before main() as usual.
+#ifdef __AFL_HAVE_MANUAL_CONTROL
+#define HARNESS_DEFERRED_INIT() __AFL_INIT()
+#else
+#define HARNESS_DEFERRED_INIT() do {} while (0)
+#endif
+
+using HarnessClock = std::chrono::steady_clock;
+
+static double elapsed_us(HarnessClock::time_point since) {
+  return std::chrono::duration<double, std::micro>(HarnessClock::now() - since).count();
+}
+
 int main(int argc, char** argv) {
+  const HarnessClock::time_point setup_start = HarnessClock::now();
+
   // Setup
-  install_signal_handlers();
+  execution::install_signal_handlers();
   
   HarnessConfig cfg;
   cfg.loadconfig();
@@ -241,45 +157,66 @@ int main(int argc, char** argv) {
   Verilated::randSeed(0);
 #endif
 
-  // Load input
-  std::vector<unsigned char> input = load_input(argc, argv);
-
-  // Initialize DUT
+  // Long-lived objects shared by every input of this process
   CpuIface* cpu = make_cpu();
-  cpu->reset();
-  cpu->load_input(input);
-
-  // Setup logging and tracing
   CrashLogger logger(cfg);
-  TraceWriter tracer = setup_trace(cfg);
-
-  // Setup golden model (Spike)
+  TraceWriter tracer;
   GoldenModel golden;
-  golden.initialize(input, cfg.trace_dir.c_str());
-
-  // Setup differential checker
   DifferentialChecker diff_checker;
+  diff_checker.set_checkpoint(cfg.diff_checkpoint);
+  if (cfg.mem_digest) {
+    cpu->track_writes(true);
+    diff_checker.enable_memory_digest(cfg.tohost_addr);
+  }
+  std::vector<unsigned char> file_input;
+  file_input.reserve(1024);
+
+  // Everything above is input independent; parse the remaining environment
+  // here so forked children inherit it instead of redoing it per input
+  golden.configure();
+  golden.set_limits(cfg.max_cycles, cfg.pc_stagnation_limit);
+  const bool trace_enabled = trace_mode_enabled();
+  tracer.set_ring(trace_ring_records());
+
+  // Clock the reset sequence once and snapshot it; forked children and later
+  // persistent iterations start from restore_state()
+  cpu->reset();
+  if (!cpu->save_state()) {
+    hwfuzz::debug::logInfo("[HARNESS] DUT has no state snapshot; resetting per input\n");
+  }
+
+  const ExecutionContext ctx{cpu, cfg, logger, tracer, golden, diff_checker, trace_enabled};
 
-  // Run execution
-  ExecutionState state = {};
-  state.exit_reason = ExitReason::None;
-  state.graceful_exit = false;
-  state.stagnation_count = 0;
-  state.last_progress_valid = false;
+  hwfuzz::debug::logInfo("[HARNESS] One-time setup took %.0f us\n", elapsed_us(setup_start));
 
-  run_execution_loop(cpu, cfg, input, logger, tracer, golden, diff_checker, state);
+  // Deferred forkserver: AFL++ forks from here rather than before main()
+  HARNESS_DEFERRED_INIT();
 
-  // Handle termination
-  if (state.graceful_exit) {
-    golden.stop();
-    hwfuzz::debug::logInfo("[HARNESS] Graceful termination after %u cycles (reason=%s).\n",
-                           state.cyc, exit_reason_text(state.exit_reason));
-    _exit(0);
+  const HarnessClock::time_point loop_start = HarnessClock::now();
+  unsigned long inputs_run = 0;
+
+  while (HARNESS_LOOP(cfg.persistent_iters)) {
+    static const unsigned char kEmptyInput[] = {0x13};  // Same placeholder as read_all_fd()
+    const unsigned char* data = nullptr;
+    size_t len = 0;
+    InputView input;
+    if (shm_testcase(data, len)) {
+      // No syscalls and no copy: the run reads AFL++'s buffer directly
+      input = len ? InputView(data, len) : InputView(kEmptyInput, sizeof(kEmptyInput));
+    } else {
+      load_input(argc, argv, file_input);
+      input = file_input;
+    }
+    // Crash artifacts are already written; abort() so AFL++ records the crash
+    if (execution::run_one_input(ctx, input) != ExecOutcome::Graceful) {
+      std::abort();
+    }
+    ++inputs_run;
   }
 
-  // Check for timeout
-  if (crash_detection::check_timeout(state.cyc, cfg.max_cycles, cpu, logger, input)) {
-    std::abort();
+  if (inputs_run > 0) {
+    hwfuzz::debug::logInfo("[HARNESS] Ran %lu input(s), %.0f us per input\n",
+                           inputs_run, elapsed_us(loop_start) / inputs_run);
   }
 
   _exit(0);
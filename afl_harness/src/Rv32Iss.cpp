@@ -0,0 +1,278 @@
+#include "Rv32Iss.hpp"
+
+#include <cstring>
+
+// ============================================================================
+// Decode Helpers
+// ============================================================================
+
+static inline uint32_t bits(uint32_t v, unsigned hi, unsigned lo) {
+  return (v >> lo) & ((1u << (hi - lo + 1)) - 1);
+}
+
+static inline int32_t sext(uint32_t v, unsigned width) {
+  uint32_t m = 1u << (width - 1);
+  return (int32_t)((v ^ m) - m);
+}
+
+static inline int32_t imm_i(uint32_t insn) { return (int32_t)insn >> 20; }
+
+static inline int32_t imm_s(uint32_t insn) {
+  return sext((bits(insn, 31, 25) << 5) | bits(insn, 11, 7), 12);
+}
+
+static inline int32_t imm_b(uint32_t insn) {
+  return sext((bits(insn, 31, 31) << 12) | (bits(insn, 7, 7) << 11) |
+              (bits(insn, 30, 25) << 5) | (bits(insn, 11, 8) << 1), 13);
+}
+
+static inline int32_t imm_j(uint32_t insn) {
+  return sext((bits(insn, 31, 31) << 20) | (bits(insn, 19, 12) << 12) |
+              (bits(insn, 20, 20) << 11) | (bits(insn, 30, 21) << 1), 21);
+}
+
+// ============================================================================
+// Execution
+// ============================================================================
+
+void Rv32Iss::reset(uint32_t pc, uint32_t sp) {
+  mem_.reset();
+  std::memset(x_, 0, sizeof(x_));
+  if (sp != 0xFFFFFFFFu) x_[2] = sp;
+  pc_ = pc;
+  instret_ = 0;
+  halted_ = false;
+  clean_ = false;
+  exit_code_ = 0;
+}
+
+void Rv32Iss::trap(CommitRec& rec, bool clean) {
+  rec.trap = 1;
+  rec.rd_addr = 0;
+  rec.rd_wdata = 0;
+  rec.pc_w = pc_;
+  halted_ = true;
+  clean_ = clean;
+}
+
+bool Rv32Iss::step(CommitRec& rec) {
+  if (halted_) return false;
+
+  rec = CommitRec();
+  const uint32_t pc = pc_;
+  const uint32_t insn = mem_.read32(pc);
+  rec.pc_r = pc;
+  rec.insn = insn;
+  ++instret_;
+
+  const uint32_t opcode = insn & 0x7F;
+  const uint32_t rd = bits(insn, 11, 7);
+  const uint32_t f3 = bits(insn, 14, 12);
+  const uint32_t rs1v = x_[bits(insn, 19, 15)];
+  const uint32_t rs2v = x_[bits(insn, 24, 20)];
+  const uint32_t f7 = bits(insn, 31, 25);
+
+  uint32_t next = pc + 4;
+  uint32_t result = 0;
+  bool writes_rd = true;
+
+  switch (opcode) {
+    case 0x37:  // LUI
+      result = insn & 0xFFFFF000u;
+      break;
+
+    case 0x17:  // AUIPC
+      result = pc + (insn & 0xFFFFF000u);
+      break;
+
+    case 0x6F:  // JAL
+      result = pc + 4;
+      next = pc + (uint32_t)imm_j(insn);
+      break;
+
+    case 0x67:  // JALR
+      if (f3 != 0) { trap(rec, false); return true; }
+      result = pc + 4;
+      next = (rs1v + (uint32_t)imm_i(insn)) & ~1u;
+      break;
+
+    case 0x63: {  // BRANCH
+      bool taken;
+      switch (f3) {
+        case 0: taken = rs1v == rs2v; break;
+        case 1: taken = rs1v != rs2v; break;
+        case 4: taken = (int32_t)rs1v <  (int32_t)rs2v; break;
+        case 5: taken = (int32_t)rs1v >= (int32_t)rs2v; break;
+        case 6: taken = rs1v <  rs2v; break;
+        case 7: taken = rs1v >= rs2v; break;
+        default: trap(rec, false); return true;
+      }
+      if (taken) next = pc + (uint32_t)imm_b(insn);
+      writes_rd = false;
+      break;
+    }
+
+    case 0x03: {  // LOAD
+      const uint32_t addr = rs1v + (uint32_t)imm_i(insn);
+      unsigned size;
+      switch (f3) {
+        case 0: case 4: size = 1; break;
+        case 1: case 5: size = 2; break;
+        case 2:         size = 4; break;
+        default: trap(rec, false); return true;
+      }
+      if (addr & (size - 1)) { trap(rec, false); return true; }
+      const unsigned shift = 8 * (addr & 3);
+      const uint32_t word = mem_.read32(addr);
+      const uint32_t raw = word >> shift;
+      switch (f3) {
+        case 0: result = (uint32_t)sext(raw & 0xFF, 8); break;
+        case 1: result = (uint32_t)sext(raw & 0xFFFF, 16); break;
+        case 4: result = raw & 0xFF; break;
+        case 5: result = raw & 0xFFFF; break;
+        default: result = word; break;
+      }
+      rec.mem_addr = addr & ~0x3u;
+      rec.mem_rmask = ((1u << size) - 1) << (addr & 3);
+      rec.mem_rdata = word;
+      rec.mem_is_load = 1;
+      break;
+    }
+
+    case 0x23: {  // STORE
+      const uint32_t addr = rs1v + (uint32_t)imm_s(insn);
+      unsigned size;
+      switch (f3) {
+        case 0: size = 1; break;
+        case 1: size = 2; break;
+        case 2: size = 4; break;
+        default: trap(rec, false); return true;
+      }
+      if (addr & (size - 1)) { trap(rec, false); return true; }
+      const unsigned shift = 8 * (addr & 3);
+      const uint8_t wstrb = (uint8_t)(((1u << size) - 1) << (addr & 3));
+      const uint32_t data = rs2v << shift;
+      mem_.write32(addr, data, wstrb);
+      rec.mem_addr = addr & ~0x3u;
+      rec.mem_wmask = wstrb;
+      rec.mem_wdata = data;
+      rec.mem_is_store = 1;
+      if (use_tohost_ && rec.mem_addr == tohost_word_) {
+        exit_code_ = data;
+        halted_ = true;
+        clean_ = true;
+      }
+      writes_rd = false;
+      break;
+    }
+
+    case 0x13: {  // OP-IMM
+      const uint32_t imm = (uint32_t)imm_i(insn);
+      const unsigned shamt = bits(insn, 24, 20);
+      switch (f3) {
+        case 0: result = rs1v + imm; break;
+        case 2: result = (int32_t)rs1v < (int32_t)imm; break;
+        case 3: result = rs1v < imm; break;
+        case 4: result = rs1v ^ imm; break;
+        case 6: result = rs1v | imm; break;
+        case 7: result = rs1v & imm; break;
+        case 1:
+          if (f7 != 0x00) { trap(rec, false); return true; }
+          result = rs1v << shamt;
+          break;
+        default:  // 5
+          if (f7 == 0x00)      result = rs1v >> shamt;
+          else if (f7 == 0x20) result = (uint32_t)((int32_t)rs1v >> shamt);
+          else { trap(rec, false); return true; }
+          break;
+      }
+      break;
+    }
+
+    case 0x33: {  // OP
+      const unsigned shamt = rs2v & 0x1F;
+      if (f7 == 0x00) {
+        switch (f3) {
+          case 0: result = rs1v + rs2v; break;
+          case 1: result = rs1v << shamt; break;
+          case 2: result = (int32_t)rs1v < (int32_t)rs2v; break;
+          case 3: result = rs1v < rs2v; break;
+          case 4: result = rs1v ^ rs2v; break;
+          case 5: result = rs1v >> shamt; break;
+          case 6: result = rs1v | rs2v; break;
+          default: result = rs1v & rs2v; break;
+        }
+      } else if (f7 == 0x20 && (f3 == 0 || f3 == 5)) {
+        result = f3 == 0 ? rs1v - rs2v : (uint32_t)((int32_t)rs1v >> shamt);
+      } else if (f7 == 0x01) {  // M extension
+        const int64_t s1 = (int32_t)rs1v, s2 = (int32_t)rs2v;
+        const uint64_t u1 = rs1v, u2 = rs2v;
+        switch (f3) {
+          case 0: result = rs1v * rs2v; break;
+          case 1: result = (uint32_t)((uint64_t)(s1 * s2) >> 32); break;
+          case 2: result = (uint32_t)((uint64_t)(s1 * (int64_t)u2) >> 32); break;
+          case 3: result = (uint32_t)((u1 * u2) >> 32); break;
+          case 4:  // DIV
+            if (rs2v == 0)                                 result = 0xFFFFFFFFu;
+            else if (rs1v == 0x80000000u && rs2v == ~0u)   result = rs1v;
+            else                                           result = (uint32_t)((int32_t)rs1v / (int32_t)rs2v);
+            break;
+          case 5:  // DIVU
+            result = rs2v == 0 ? 0xFFFFFFFFu : rs1v / rs2v;
+            break;
+          case 6:  // REM
+            if (rs2v == 0)                                 result = rs1v;
+            else if (rs1v == 0x80000000u && rs2v == ~0u)   result = 0;
+            else                                           result = (uint32_t)((int32_t)rs1v % (int32_t)rs2v);
+            break;
+          default:  // REMU
+            result = rs2v == 0 ? rs1v : rs1v % rs2v;
+            break;
+        }
+      } else {
+        trap(rec, false);
+        return true;
+      }
+      break;
+    }
+
+    case 0x0F:  // FENCE / FENCE.I: no caches to order
+      writes_rd = false;
+      break;
+
+    case 0x73: {  // SYSTEM
+      if (insn == 0x00000073u) { trap(rec, true); return true; }   // ECALL
+      if (insn == 0x00100073u) { trap(rec, false); return true; }  // EBREAK
+      // rdcycle[h] / rdinstret[h]: CSRRS rd, csr, x0
+      const uint32_t csr = bits(insn, 31, 20);
+      if (f3 != 2 || bits(insn, 19, 15) != 0) { trap(rec, false); return true; }
+      const uint64_t count = instret_ - 1;  // Excludes this instruction
+      switch (csr) {
+        case 0xC00: case 0xC02: result = (uint32_t)count; break;
+        case 0xC80: case 0xC82: result = (uint32_t)(count >> 32); break;
+        default: trap(rec, false); return true;
+      }
+      break;
+    }
+
+    default:  // Includes compressed encodings (COMPRESSED_ISA=0)
+      trap(rec, false);
+      return true;
+  }
+
+  if (next & 0x3u) {  // Misaligned jump or branch target
+    rec.mem_addr = rec.mem_rmask = rec.mem_wmask = 0;
+    rec.mem_is_load = rec.mem_is_store = 0;
+    trap(rec, false);
+    return true;
+  }
+
+  if (writes_rd && rd != 0) {
+    x_[rd] = result;
+    rec.rd_addr = rd;
+    rec.rd_wdata = result;
+  }
+  rec.pc_w = next;
+  pc_ = next;
+  return true;
+}
@@ -3,12 +3,16 @@
 #include <vector>
 #include <string>
 #include <sstream>
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <elf.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
 #include <boost/process.hpp>
 
 namespace bp = boost::process;
@@ -84,7 +88,7 @@ std::string format_arg(const std::string& arg) {
   return quoted;
 }
 
-std::string build_spike_elf(const std::vector<unsigned char>& input) {
+std::string build_spike_elf(InputView input) {
   // Create temporary binary file
   char tmpbin[] = "/tmp/dut_in_XXXXXX.bin";
   int bfd = ::mkstemps(tmpbin, 4);
@@ -201,4 +205,70 @@ std::string build_spike_elf(const std::vector<unsigned char>& input) {
   return elfpath;
 }
 
+int open_elf_image(std::string& path) {
+  int fd = -1;
+#ifdef MFD_CLOEXEC
+  fd = ::memfd_create("spike_elf", 0);
+#endif
+  if (fd < 0) {
+    // No memfd: an unlinked /dev/shm file behaves the same through /proc
+    char tmpl[] = "/dev/shm/spike_elf_XXXXXX";
+    fd = ::mkstemp(tmpl);
+    if (fd < 0) {
+      hwfuzz::debug::logError("[SPIKE] Failed to create in-memory ELF file: %s\n", std::strerror(errno));
+      return -1;
+    }
+    ::unlink(tmpl);
+  }
+  // Not /proc/self: Spike resolves the path in its own process
+  path = "/proc/" + std::to_string(::getpid()) + "/fd/" + std::to_string(fd);
+  return fd;
+}
+
+bool write_elf_image(int fd, InputView input,
+                     uint32_t load_addr, uint32_t ram_base) {
+  Elf32_Ehdr eh;
+  std::memset(&eh, 0, sizeof(eh));
+  std::memcpy(eh.e_ident, ELFMAG, SELFMAG);
+  eh.e_ident[EI_CLASS] = ELFCLASS32;
+  eh.e_ident[EI_DATA] = ELFDATA2LSB;
+  eh.e_ident[EI_VERSION] = EV_CURRENT;
+  eh.e_ident[EI_OSABI] = ELFOSABI_NONE;
+  eh.e_type = ET_EXEC;
+  eh.e_machine = EM_RISCV;
+  eh.e_version = EV_CURRENT;
+  eh.e_entry = load_addr;  // ld falls back to the start of the (empty) .text
+  eh.e_phoff = sizeof(Elf32_Ehdr);
+  eh.e_ehsize = sizeof(Elf32_Ehdr);
+  eh.e_phentsize = sizeof(Elf32_Phdr);
+  eh.e_phnum = 1;
+  eh.e_shentsize = sizeof(Elf32_Shdr);
+
+  // objcopy -I binary puts the bytes in .data, which link.ld places in RAM
+  // with its load address in ROM; Spike loads segments at p_paddr
+  Elf32_Phdr ph;
+  std::memset(&ph, 0, sizeof(ph));
+  ph.p_type = PT_LOAD;
+  ph.p_offset = sizeof(Elf32_Ehdr) + sizeof(Elf32_Phdr);
+  ph.p_vaddr = ram_base;
+  ph.p_paddr = load_addr;
+  ph.p_filesz = (Elf32_Word)input.size();
+  ph.p_memsz = (Elf32_Word)input.size();
+  ph.p_flags = PF_R | PF_W;
+  ph.p_align = 4;
+
+  // Rewritten in place for every input; ftruncate drops a longer previous image
+  struct iovec iov[3] = {
+    {&eh, sizeof(eh)},
+    {&ph, sizeof(ph)},
+    {const_cast<unsigned char*>(input.data()), input.size()},
+  };
+  const ssize_t total = (ssize_t)(sizeof(eh) + sizeof(ph) + input.size());
+  if (::ftruncate(fd, 0) != 0 || ::pwritev(fd, iov, 3, 0) != total) {
+    hwfuzz::debug::logError("[SPIKE] Failed to write in-memory ELF: %s\n", std::strerror(errno));
+    return false;
+  }
+  return true;
+}
+
 } // namespace spike_helpers
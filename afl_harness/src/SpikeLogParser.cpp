@@ -0,0 +1,397 @@
+#include "SpikeLogParser.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <utility>
+
+// ============================================================================
+// Character Classes
+// ============================================================================
+
+namespace {
+
+enum : uint8_t { kSpace = 1, kWord = 2, kHex = 4, kDigit = 8 };
+
+struct CharTable {
+  uint8_t cls[256];
+  uint8_t hex[256];
+
+  CharTable() : cls(), hex() {
+    for (const char* p = " \t\r\n\f\v"; *p; ++p) cls[(uint8_t)*p] |= kSpace;
+    for (int c = '0'; c <= '9'; ++c) { cls[c] |= kWord | kHex | kDigit; hex[c] = (uint8_t)(c - '0'); }
+    for (int c = 'a'; c <= 'z'; ++c) cls[c] |= kWord;
+    for (int c = 'A'; c <= 'Z'; ++c) cls[c] |= kWord;
+    for (int c = 'a'; c <= 'f'; ++c) { cls[c] |= kHex; hex[c] = (uint8_t)(c - 'a' + 10); }
+    for (int c = 'A'; c <= 'F'; ++c) { cls[c] |= kHex; hex[c] = (uint8_t)(c - 'A' + 10); }
+    cls[(uint8_t)'_'] |= kWord;
+  }
+};
+
+const CharTable kChars;
+
+inline bool is(char c, uint8_t mask) { return (kChars.cls[(uint8_t)c] & mask) != 0; }
+
+/// Forward-only scanner over one line; every match step fails without side
+/// effects on the caller's state other than the cursor position.
+struct Cursor {
+  const char* p;
+  const char* e;
+
+  bool at_end() const { return p >= e; }
+  bool peek(char c) const { return p < e && *p == c; }
+
+  void skip_ws() { while (p < e && is(*p, kSpace)) ++p; }
+
+  bool ws1() {
+    if (p >= e || !is(*p, kSpace)) return false;
+    skip_ws();
+    return true;
+  }
+
+  bool opt(char c) {
+    if (peek(c)) { ++p; return true; }
+    return false;
+  }
+
+  bool lit(std::string_view s) {
+    if ((size_t)(e - p) < s.size() || std::memcmp(p, s.data(), s.size()) != 0) return false;
+    p += s.size();
+    return true;
+  }
+
+  // One or more hex digits; wraps like the (uint32_t)std::stoul it replaces
+  bool hex(uint32_t& v, std::string_view* text = nullptr) {
+    const char* s = p;
+    uint64_t acc = 0;
+    while (p < e && is(*p, kHex)) acc = (acc << 4) | kChars.hex[(uint8_t)*p++];
+    if (p == s) return false;
+    v = (uint32_t)acc;
+    if (text) *text = std::string_view(s, (size_t)(p - s));
+    return true;
+  }
+
+  bool dec(unsigned& v) {
+    const char* s = p;
+    unsigned acc = 0;
+    while (p < e && is(*p, kDigit)) acc = acc * 10 + (unsigned)(*p++ - '0');
+    if (p == s) return false;
+    v = acc;
+    return true;
+  }
+};
+
+inline Cursor cursor_at(std::string_view line, size_t pos) {
+  return Cursor{line.data() + pos, line.data() + line.size()};
+}
+
+inline bool word_boundary_before(std::string_view line, size_t pos) {
+  return pos == 0 || !is(line[pos - 1], kWord);
+}
+
+// "x<n>) := 0x<v>"
+bool match_simple_reg(std::string_view line, unsigned& rd, uint32_t& v) {
+  for (size_t i = line.find('x'); i != std::string_view::npos; i = line.find('x', i + 1)) {
+    if (!word_boundary_before(line, i)) continue;
+    Cursor c = cursor_at(line, i + 1);
+    if (!c.dec(rd) || !c.opt(')')) continue;
+    c.skip_ws();
+    if (!c.lit(":=")) continue;
+    c.skip_ws();
+    if (c.lit("0x") && c.hex(v)) return true;
+  }
+  return false;
+}
+
+// "W x<n> <- 0x<v>", also W0/W1, an optional quote and any run of ":<=-"
+bool match_reg_write(std::string_view line, unsigned& rd, uint32_t& v) {
+  for (size_t i = line.find('W'); i != std::string_view::npos; i = line.find('W', i + 1)) {
+    if (!word_boundary_before(line, i)) continue;
+    Cursor c = cursor_at(line, i + 1);
+    if (c.peek('0') || c.peek('1')) ++c.p;
+    c.opt('"');
+    c.skip_ws();
+    if (!c.opt('x') || !c.dec(rd)) continue;
+    c.skip_ws();
+    const char* ops = c.p;
+    while (!c.at_end() && (*c.p == ':' || *c.p == '<' || *c.p == '=' || *c.p == '-')) ++c.p;
+    if (c.p == ops) continue;
+    c.skip_ws();
+    if (c.lit("0x") && c.hex(v)) return true;
+  }
+  return false;
+}
+
+// "mem [0x<addr>] <op> 0x<data>" with store ops "=", "<-", ":" or load ops "->", "=>"
+bool match_mem(std::string_view line, bool store, uint32_t& addr, uint32_t& data) {
+  for (size_t i = line.find("mem"); i != std::string_view::npos; i = line.find("mem", i + 1)) {
+    if (!word_boundary_before(line, i)) continue;
+    Cursor c = cursor_at(line, i + 3);
+    c.skip_ws();
+    c.opt('[');
+    if (!c.lit("0x") || !c.hex(addr)) continue;
+    c.opt(']');
+    c.skip_ws();
+    const bool op = store ? (c.opt('=') || c.lit("<-") || c.opt(':'))
+                          : (c.lit("->") || c.lit("=>"));
+    if (!op) continue;
+    c.skip_ws();
+    if (c.lit("0x") && c.hex(data)) return true;
+  }
+  return false;
+}
+
+} // namespace
+
+// ============================================================================
+// Line Matchers
+// ============================================================================
+
+namespace spike_log {
+
+bool parse_commit(std::string_view line, uint32_t& pc, uint32_t& insn) {
+  for (size_t i = line.find("core"); i != std::string_view::npos; i = line.find("core", i + 1)) {
+    Cursor c = cursor_at(line, i + 4);
+    if (c.ws1() && c.lit("0:") && c.ws1() && c.lit("0x") && c.hex(pc) &&
+        c.ws1() && c.lit("(0x") && c.hex(insn) && c.opt(')')) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool is_trap_line(std::string_view line) {
+  return line.find("exception") != std::string_view::npos &&
+         line.find("core") != std::string_view::npos;
+}
+
+std::string trap_summary(std::string_view line) {
+  // "core <n>: exception <cause>, epc 0x<epc>"
+  for (size_t i = line.find("core"); i != std::string_view::npos; i = line.find("core", i + 1)) {
+    Cursor c = cursor_at(line, i + 4);
+    unsigned hart;
+    if (!c.ws1() || !c.dec(hart) || !c.opt(':') || !c.ws1() || !c.lit("exception") || !c.ws1()) {
+      continue;
+    }
+    const char* cause = c.p;
+    while (!c.at_end() && is(*c.p, kWord)) ++c.p;
+    std::string_view cause_text(cause, (size_t)(c.p - cause));
+    uint32_t epc;
+    std::string_view epc_text;
+    if (cause_text.empty() || !c.opt(',') || !c.ws1() || !c.lit("epc") || !c.ws1() ||
+        !c.lit("0x") || !c.hex(epc, &epc_text)) {
+      continue;
+    }
+    std::string summary(cause_text);
+    summary += " at epc=0x";
+    summary += epc_text;
+    return summary;
+  }
+  while (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+  return std::string(line);
+}
+
+bool parse_detail(std::string_view line, CommitRec& rec) {
+  unsigned rd;
+  uint32_t v, addr;
+  // Register numbers above x31 are garbage, not a write to remember
+  if ((match_simple_reg(line, rd, v) || match_reg_write(line, rd, v)) && rd < 32) {
+    rec.rd_addr = rd;
+    rec.rd_wdata = v;
+    return true;
+  }
+  if (match_mem(line, true, addr, v)) {
+    rec.mem_addr = addr;
+    rec.mem_wdata = v;
+    rec.mem_is_store = 1;
+    return true;
+  }
+  if (match_mem(line, false, addr, v)) {
+    rec.mem_addr = addr;
+    rec.mem_rdata = v;
+    rec.mem_is_load = 1;
+    return true;
+  }
+  return false;
+}
+
+} // namespace spike_log
+
+// ============================================================================
+// LineBuffer
+// ============================================================================
+
+void LineBuffer::reset(int fd) {
+  reset([fd](char* buf, size_t n) {
+    ssize_t r;
+    do {
+      r = ::read(fd, buf, n);
+    } while (r < 0 && errno == EINTR);
+    return r;
+  });
+}
+
+void LineBuffer::reset(Reader reader) {
+  reader_ = std::move(reader);
+  begin_ = end_ = 0;
+  last_ = std::string_view();
+  replay_ = false;
+  eof_ = false;
+}
+
+bool LineBuffer::next(std::string_view& line) {
+  if (replay_) {
+    replay_ = false;
+    line = last_;
+    return true;
+  }
+
+  for (;;) {
+    char* base = buf_.data();
+    if (begin_ < end_) {
+      const void* nl = std::memchr(base + begin_, '\n', end_ - begin_);
+      if (nl) {
+        size_t n = (size_t)(static_cast<const char*>(nl) - (base + begin_));
+        last_ = std::string_view(base + begin_, n);
+        begin_ += n + 1;
+        line = last_;
+        return true;
+      }
+    }
+
+    // Slide the partial line to the front before reading more
+    if (begin_ > 0) {
+      std::memmove(base, base + begin_, end_ - begin_);
+      end_ -= begin_;
+      begin_ = 0;
+    }
+
+    if (eof_ || end_ == buf_.size()) {
+      // Unterminated last line, or a line longer than the buffer
+      if (end_ == 0) return false;
+      last_ = std::string_view(base, end_);
+      begin_ = end_;
+      line = last_;
+      return true;
+    }
+
+    ssize_t n = reader_ ? reader_(base + end_, buf_.size() - end_) : 0;
+    if (n <= 0) {
+      eof_ = true;
+      continue;
+    }
+    end_ += (size_t)n;
+  }
+}
+
+// ============================================================================
+// SpikeLogRing
+// ============================================================================
+
+void SpikeLogRing::set_capacity(size_t chunks) {
+  capacity_ = chunks;
+  chunks_.clear();
+  chunks_.resize(capacity_ ? capacity_ : 1);
+  clear();
+}
+
+void SpikeLogRing::clear() {
+  const size_t used = capacity_ ? std::min(total_, capacity_) : total_;
+  for (size_t i = 0; i < used; ++i) chunks_[i].clear();
+  total_ = 1;
+}
+
+void SpikeLogRing::begin_chunk() {
+  if (!capacity_ && total_ == chunks_.size()) chunks_.emplace_back();
+  ++total_;
+  current().clear();
+}
+
+void SpikeLogRing::append_line(std::string_view line) {
+  std::string& chunk = current();
+  chunk.append(line.data(), line.size());
+  chunk.push_back('\n');
+}
+
+void SpikeLogRing::dump(std::string& out) const {
+  size_t first = 0;
+  if (capacity_ && total_ > capacity_) {
+    first = total_ - capacity_;
+    out += "----- " + std::to_string(first) + " earlier chunks dropped -----\n";
+  }
+  for (size_t n = first; n < total_; ++n) out += chunks_[slot(n)];
+}
+
+// ============================================================================
+// SpikeLogParser
+// ============================================================================
+
+void SpikeLogParser::reset(LineBuffer::Reader reader, SpikeLogRing* raw_log) {
+  lines_.reset(std::move(reader));
+  raw_log_ = raw_log;
+  trap_summary_.clear();
+  commits_ = 0;
+}
+
+void SpikeLogParser::reset(int fd, SpikeLogRing* raw_log) {
+  lines_.reset(fd);
+  raw_log_ = raw_log;
+  trap_summary_.clear();
+  commits_ = 0;
+}
+
+void SpikeLogParser::log_line(std::string_view line) {
+  if (raw_log_) raw_log_->append_line(line);
+}
+
+SpikeLogParser::Event SpikeLogParser::next(CommitRec& rec) {
+  std::string_view s;
+  while (lines_.next(s)) {
+    if (spike_log::is_trap_line(s)) {
+      log_line(s);
+      trap_summary_ = spike_log::trap_summary(s);
+      return Event::FatalTrap;
+    }
+
+    uint32_t pc, insn;
+    if (!spike_log::parse_commit(s, pc, insn)) {
+      log_line(s);  // Preamble / misc output
+      continue;
+    }
+
+    ++commits_;
+    if (raw_log_) {
+      char header[80];
+      const int n = std::snprintf(header, sizeof(header),
+                                  "----- SPIKE INSTR #%zu pc=0x%08x insn=0x%08x -----\n",
+                                  commits_, pc, insn);
+      raw_log_->begin_chunk();
+      raw_log_->append(std::string_view(header, (size_t)n));
+    }
+    log_line(s);
+
+    rec.pc_w = pc;
+    rec.insn = insn;
+    rec.rd_addr = 0; rec.rd_wdata = 0; rec.mem_addr = 0; rec.mem_rmask = 0; rec.mem_wmask = 0; rec.trap = 0;
+    rec.mem_is_load = rec.mem_is_store = 0; rec.mem_wdata = rec.mem_rdata = 0;
+
+    // Register/memory lines follow the commit line
+    for (int i = 0; i < 16; ++i) {
+      std::string_view d;
+      if (!lines_.next(d)) break;
+      if (spike_log::parse_commit(d, pc, insn)) {
+        lines_.unread();  // Belongs to the next call
+        break;
+      }
+      log_line(d);
+      spike_log::parse_detail(d, rec);
+      if (d.empty()) break;
+    }
+
+    if (raw_log_) raw_log_->append("----- END SPIKE INSTR -----\n");
+    return Event::Commit;
+  }
+  return Event::End;
+}
@@ -1,20 +1,19 @@
 #include "SpikeProcess.hpp"
-#include "SpikeExit.hpp"
+
+#include "Utils.hpp"
+#include <hwfuzz/Debug.hpp>
 
 #include <cerrno>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
-#include <exception>
-#include <regex>
-#include <sstream>
+#include <fcntl.h>
 #include <vector>
 #include <sys/wait.h>
-
-namespace bp = boost::process;
+#include <unistd.h>
 
 std::string SpikeProcess::status_string() const {
-  if (!status_valid_) return std::string("unknown");
+  if (!status_valid_) return std::string(killed_ ? "killed" : "unknown");
   if (WIFEXITED(last_status_)) {
     return std::string("exited ") + std::to_string(WEXITSTATUS(last_status_));
   }
@@ -31,10 +30,10 @@ bool SpikeProcess::start(const std::string& spike_bin, const std::string& elf_pa
   status_valid_ = false;
   last_status_ = 0;
   start_error_.clear();
-  pending_line_.clear();
-  instr_index_ = 0;
   fatal_trap_seen_ = false;
   fatal_trap_summary_.clear();
+  at_eof_ = false;
+  killed_ = false;
   std::vector<std::string> args{"-l", "--isa=" + isa};
   if (!pk_bin.empty()) args.push_back(pk_bin);
   args.push_back(elf_path);
@@ -61,170 +60,100 @@ bool SpikeProcess::start(const std::string& spike_bin, const std::string& elf_pa
     spike_cmd_.append(quote_arg(arg));
   }
 
-  child_stream_ = std::make_unique<bp::ipstream>();
-  try {
-    child_.emplace(bp::exe = spike_bin,
-                   bp::args = args,
-                   bp::std_out > *child_stream_,
-                   bp::std_err > *child_stream_);
-  } catch (const std::exception &ex) {
-    start_error_ = std::string("[ERROR] Failed to launch Spike: ") + ex.what();
-    child_stream_.reset();
+  args.insert(args.begin(), spike_bin);
+  Subprocess::Options opt;
+  opt.primary = Subprocess::Stream::Err;  // spike -l logs to stderr
+  if (!proc_.spawn(args, opt)) {
+    start_error_ = std::string("[ERROR] Failed to launch Spike: ") + proc_.error();
     return false;
   }
-  if (!log_path_.empty()) {
-    // Open in append mode so we never overwrite previous contents.
-    log_file_ = std::fopen(log_path_.c_str(), "a");
-    if (log_file_) {
-      // Line-buffer the file so it shows up while running
-      setvbuf(log_file_, nullptr, _IOLBF, 0);
-    }
-    // If fopen failed, continue without file gracefully
+  // The raw log stays in memory; dump_log() writes it out when asked
+  const bool logging = !log_path_.empty();
+  if (logging) {
+    log_ring_.clear();
+    dumped_ = false;
+    sampled_ = sample_every_ && ++runs_ % sample_every_ == 0;
   }
-  // prepare regexes
-  commit_re_ = std::regex("core\\s+0:\\s+0x([0-9a-fA-F]+)\\s+\\(0x([0-9a-fA-F]+)\\)");
-  reg_write_re_ = std::regex("\\b(W|W0|W1)\"?\\s*x([0-9]+)\\s*[:<=-]+\\s*0x([0-9a-fA-F]+)");
-  simple_reg_re_ = std::regex("\\bx([0-9]+)\\)\\s*:=\\s*0x([0-9a-fA-F]+)");
+  parser_.reset([this](char* buf, size_t n) { return proc_.read(buf, n); },
+                logging ? &log_ring_ : nullptr);
+  return true;
+}
+
+bool SpikeProcess::dump_log(const char* reason) {
+  if (log_path_.empty() || dumped_ || log_ring_.empty()) return false;
+  dumped_ = true;
+
+  std::string text;
+  text.reserve(64 * 1024);
+  text += "===== SPIKE LOG (";
+  text += reason;
+  text += ") pid " + std::to_string(::getpid()) + " =====\n";
+  text += "Command: " + spike_cmd_ + "\n";
+  log_ring_.dump(text);
+  text += "===== END SPIKE LOG =====\n";
+
+  // One O_APPEND write per dump: workers sharing the file never interleave
+  int fd = ::open(log_path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (fd < 0) return false;
+  utils::safe_write_all(fd, text.data(), text.size());
+  ::close(fd);
   return true;
 }
 
 void SpikeProcess::stop() {
-  if (child_) {
-    try {
-      child_->wait();
-      int exit_code = child_->exit_code();
-      last_status_ = exit_code << 8;
-      status_valid_ = true;
-    } catch (const std::exception &ex) {
-      start_error_ = std::string("[WARN] Failed to collect Spike status: ") + ex.what();
-      status_valid_ = false;
+  if (proc_.running()) {
+    if (at_eof_) {
+      // Spike closed its log, so it is already on its way out
+      proc_.finish(kill_timeout_ms_);
+    } else {
+      // Stopped early (DUT done, trap, budget): don't wait for a looping Spike
+      proc_.kill_async(kill_timeout_ms_);
+      killed_ = true;
+    }
+    if (!log_path_.empty()) {
+      // Target console output (HTIF) arrives on stdout, kept apart from the log
+      const std::string console = proc_.captured().str();
+      if (!console.empty()) {
+        log_ring_.append("----- SPIKE STDOUT -----\n");
+        log_ring_.append(console);
+        log_ring_.append("\n----- END SPIKE STDOUT -----\n");
+      }
     }
-    child_.reset();
   }
-  child_stream_.reset();
-  if (log_file_) { std::fclose(log_file_); log_file_ = nullptr; }
+  if (proc_.has_status()) {
+    last_status_ = proc_.status();
+    status_valid_ = true;
+  }
+  if (sampled_) {
+    sampled_ = false;
+    dump_log("sample");
+  }
 }
 
 bool SpikeProcess::next_commit(CommitRec& rec) {
-  if (!child_stream_) return false;
-  // First, find the next commit line; pass-through any preamble lines to log raw
-  for (;;) {
-    std::string s;
-    if (!pending_line_.empty()) {
-      s.swap(pending_line_);
-    } else {
-      if (!std::getline(*child_stream_, s)) break;
-      s.push_back('\n');
-    }
-    // try to match commit line
-    std::smatch m;
-    static const std::regex trap_re(R"(core\s+\d+:\s+exception\s+([A-Za-z0-9_]+),\s+epc\s+0x([0-9a-fA-F]+))");
-    // Once we've seen a fatal trap, immediately stop reading further output
-    if (fatal_trap_seen_) {
-      stop();
-      return false;
-    }
-    if (s.find("exception") != std::string::npos && s.find("core") != std::string::npos) {
-      if (log_file_) {
-        std::fwrite(s.data(), 1, s.size(), log_file_);
-        std::fflush(log_file_);
-      }
-      std::smatch trap_match;
-      if (std::regex_search(s, trap_match, trap_re)) {
-        std::string summary = trap_match[1].str();
-        summary += " at epc=0x";
-        summary += trap_match[2].str();
-        fatal_trap_summary_ = summary;
-      } else {
-        std::string summary = s;
-        while (!summary.empty() && (summary.back() == '\n' || summary.back() == '\r')) summary.pop_back();
-        fatal_trap_summary_ = summary;
-      }
+  if (!proc_.running()) return false;
+  // Once we've seen a fatal trap, immediately stop reading further output
+  if (fatal_trap_seen_) {
+    stop();
+    return false;
+  }
+
+  switch (parser_.next(rec)) {
+    case SpikeLogParser::Event::Commit:
+      return true;
+
+    case SpikeLogParser::Event::FatalTrap:
+      fatal_trap_summary_ = parser_.trap_summary();
       fatal_trap_seen_ = true;
-      pending_line_.clear();
-      if (child_) {
-        try {
-          child_->terminate();
-        } catch (const std::exception &) {
-          // ignore terminate failures; wait() handles final status
-        }
-      }
       stop();
       return false;
-    }
-    if (std::regex_search(s, m, commit_re_)) {
-      // We'll accumulate the raw lines for this instruction to a chunk and emit with separators
-      std::vector<std::string> chunk;
-      {
-        std::ostringstream hdr;
-        hdr << "----- SPIKE INSTR #" << (instr_index_ + 1)
-            << " pc=0x" << std::hex << m[1].str() << " insn=0x" << m[2].str() << " -----\n";
-        chunk.push_back(hdr.str());
-      }
-      chunk.push_back(s);
-      // parse pc and insn
-      rec.pc_w = (uint32_t)std::stoul(m[1].str(), nullptr, 16);
-      rec.insn = (uint32_t)std::stoul(m[2].str(), nullptr, 16);
-      // reset other fields; subsequent lines may contain register/mem writes
-      rec.rd_addr = 0; rec.rd_wdata = 0; rec.mem_addr = 0; rec.mem_rmask = 0; rec.mem_wmask = 0; rec.trap = 0;
-      rec.mem_is_load = rec.mem_is_store = 0; rec.mem_wdata = rec.mem_rdata = 0;
-      // try to collect subsequent lines for register writes (non-blocking read of a few lines)
-      // Note: spike prints reg writes on subsequent lines; we'll attempt to parse up to 16 lines
-      for (int i = 0; i < 16; ++i) {
-        std::string s2;
-        if (!std::getline(*child_stream_, s2)) break;
-        s2.push_back('\n');
-        // If next commit appears, stash it for next call and stop here
-        std::smatch mnext;
-        if (std::regex_search(s2, mnext, commit_re_)) {
-          pending_line_ = s2;
-          break;
-        }
-        chunk.push_back(s2);
-        std::smatch mr;
-        if (std::regex_search(s2, mr, simple_reg_re_)) {
-          int r = std::stoi(mr[1].str());
-          uint32_t v = (uint32_t)std::stoul(mr[2].str(), nullptr, 16);
-          rec.rd_addr = r; rec.rd_wdata = v;
-        } else if (std::regex_search(s2, mr, reg_write_re_)) {
-          int r = std::stoi(mr[2].str());
-          uint32_t v = (uint32_t)std::stoul(mr[3].str(), nullptr, 16);
-          rec.rd_addr = r; rec.rd_wdata = v;
-        } else {
-          // Best-effort memory access parsing; formats vary across spike versions.
-          // Try to catch common patterns like:
-          //   mem [0xADDR] = 0xDATA   (store)
-          //   mem [0xADDR] -> 0xDATA  (load)
-          std::smatch mm;
-          static const std::regex mem_store_re("\\bmem\\s*\\[?0x([0-9a-fA-F]+)\\]?\\s*(?:=|<-|:)\\s*0x([0-9a-fA-F]+)");
-          static const std::regex mem_load_re ("\\bmem\\s*\\[?0x([0-9a-fA-F]+)\\]?\\s*(?:->|=>)\\s*0x([0-9a-fA-F]+)");
-          if (std::regex_search(s2, mm, mem_store_re)) {
-            rec.mem_addr = (uint32_t)std::stoul(mm[1].str(), nullptr, 16);
-            rec.mem_wdata = (uint32_t)std::stoul(mm[2].str(), nullptr, 16);
-            rec.mem_is_store = 1;
-          } else if (std::regex_search(s2, mm, mem_load_re)) {
-            rec.mem_addr = (uint32_t)std::stoul(mm[1].str(), nullptr, 16);
-            rec.mem_rdata = (uint32_t)std::stoul(mm[2].str(), nullptr, 16);
-            rec.mem_is_load = 1;
-          }
-        }
-        // break early on blank line
-        if (s2.size() <= 1) break;
-      }
-      // footer separator
-      chunk.push_back("----- END SPIKE INSTR -----\n");
-      // emit the chunk to the raw log file
-      if (log_file_) {
-        for (const auto& ln : chunk) {
-          std::fwrite(ln.data(), 1, ln.size(), log_file_);
-        }
-        std::fflush(log_file_);
+
+    case SpikeLogParser::Event::End:
+      at_eof_ = proc_.eof();  // Not after interrupt(), a stall or a read error
+      if (proc_.timed_out()) {
+        hwfuzz::debug::logWarn("[SPIKE] No output for the stall timeout; stopping this run\n");
       }
-      instr_index_++;
-      return true;
-    }
-    // Not a commit: write through raw line (preamble / misc output)
-    if (log_file_) { std::fwrite(s.data(), 1, s.size(), log_file_); std::fflush(log_file_); }
+      break;
   }
   // EOF or read error: close and record status so caller can inspect
   stop();
@@ -0,0 +1,361 @@
+#include "Subprocess.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/eventfd.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+extern char** environ;
+
+// ============================================================================
+// ByteRing
+// ============================================================================
+
+void ByteRing::append(const char* data, size_t n) {
+  const size_t cap = buf_.size();
+  if (cap == 0) return;
+  if (n >= cap) {
+    std::memcpy(buf_.data(), data + (n - cap), cap);
+    head_ = 0;
+    size_ = cap;
+    return;
+  }
+  size_t first = std::min(n, cap - head_);
+  std::memcpy(buf_.data() + head_, data, first);
+  std::memcpy(buf_.data(), data + first, n - first);
+  head_ = (head_ + n) % cap;
+  size_ = std::min(size_ + n, cap);
+}
+
+std::string ByteRing::str() const {
+  std::string out;
+  out.reserve(size_);
+  size_t start = (head_ + buf_.size() - size_) % (buf_.empty() ? 1 : buf_.size());
+  size_t first = std::min(size_, buf_.size() - start);
+  out.append(buf_.data() + start, first);
+  out.append(buf_.data(), size_ - first);
+  return out;
+}
+
+// ============================================================================
+// Spawn
+// ============================================================================
+
+namespace {
+
+void set_nonblocking(int fd) {
+  int flags = ::fcntl(fd, F_GETFL);
+  if (flags >= 0) ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+void grow_pipe(int fd, size_t size) {
+#ifdef F_SETPIPE_SZ
+  // Best effort: capped by /proc/sys/fs/pipe-max-size for unprivileged users
+  if (size > 0) ::fcntl(fd, F_SETPIPE_SZ, (int)size);
+#else
+  (void)fd;
+  (void)size;
+#endif
+}
+
+void close_fd(int& fd) {
+  if (fd >= 0) {
+    ::close(fd);
+    fd = -1;
+  }
+}
+
+// Children killed by kill_async() and not reaped yet. Shared by every
+// Subprocess in the process (batch workers run on several threads).
+struct Abandoned {
+  pid_t pid;
+  std::chrono::steady_clock::time_point deadline;
+};
+std::mutex g_abandoned_mutex;
+std::vector<Abandoned> g_abandoned;
+
+// Reap whatever has exited; block on anything past its deadline
+void reap_abandoned() {
+  std::lock_guard<std::mutex> lock(g_abandoned_mutex);
+  const auto now = std::chrono::steady_clock::now();
+  size_t kept = 0;
+  for (const Abandoned& a : g_abandoned) {
+    int st;
+    pid_t r;
+    do {
+      r = ::waitpid(a.pid, &st, now >= a.deadline ? 0 : WNOHANG);
+    } while (r < 0 && errno == EINTR);
+    if (r == 0) g_abandoned[kept++] = a;
+  }
+  g_abandoned.resize(kept);
+}
+
+} // namespace
+
+Subprocess::Subprocess() : wake_fd_(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {}
+
+Subprocess::~Subprocess() {
+  terminate();
+  close_fd(wake_fd_);
+}
+
+bool Subprocess::spawn(const std::vector<std::string>& argv, const Options& opt) {
+  terminate();
+  reap_abandoned();
+  uint64_t stale;
+  while (wake_fd_ >= 0 && ::read(wake_fd_, &stale, sizeof(stale)) > 0) {}
+  eof_ = false;
+  timed_out_ = false;
+  status_valid_ = false;
+  status_ = 0;
+  error_.clear();
+  if (captured_.capacity() != opt.capture_size) {
+    captured_ = ByteRing(opt.capture_size);
+  }
+  captured_.clear();
+  if (argv.empty()) {
+    error_ = "empty command";
+    return false;
+  }
+
+  int in[2] = {-1, -1}, out[2] = {-1, -1}, err[2] = {-1, -1};
+  auto close_all = [&]() {
+    for (int* p : {in, out, err}) {
+      close_fd(p[0]);
+      close_fd(p[1]);
+    }
+  };
+  if ((opt.pipe_stdin && ::pipe2(in, O_CLOEXEC) != 0) ||
+      ::pipe2(out, O_CLOEXEC) != 0 || ::pipe2(err, O_CLOEXEC) != 0) {
+    error_ = std::string("pipe: ") + std::strerror(errno);
+    close_all();
+    return false;
+  }
+
+  posix_spawn_file_actions_t fa;
+  posix_spawn_file_actions_init(&fa);
+  if (opt.pipe_stdin) {
+    posix_spawn_file_actions_adddup2(&fa, in[0], STDIN_FILENO);
+  } else {
+    posix_spawn_file_actions_addopen(&fa, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+  }
+  posix_spawn_file_actions_adddup2(&fa, out[1], STDOUT_FILENO);
+  posix_spawn_file_actions_adddup2(&fa, err[1], STDERR_FILENO);
+
+  // The harness ignores SIGPIPE; the child must not inherit that
+  posix_spawnattr_t attr;
+  posix_spawnattr_init(&attr);
+  sigset_t mask, defaults;
+  sigemptyset(&mask);
+  sigemptyset(&defaults);
+  sigaddset(&defaults, SIGPIPE);
+  posix_spawnattr_setsigmask(&attr, &mask);
+  posix_spawnattr_setsigdefault(&attr, &defaults);
+  posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+  std::vector<char*> args;
+  args.reserve(argv.size() + 1);
+  for (const auto& a : argv) args.push_back(const_cast<char*>(a.c_str()));
+  args.push_back(nullptr);
+
+  pid_t pid = -1;
+  int rc = ::posix_spawnp(&pid, args[0], &fa, &attr, args.data(), environ);
+  posix_spawn_file_actions_destroy(&fa);
+  posix_spawnattr_destroy(&attr);
+  if (rc != 0) {
+    error_ = argv[0] + ": " + std::strerror(rc);
+    close_all();
+    return false;
+  }
+
+  pid_ = pid;
+  close_fd(in[0]);
+  close_fd(out[1]);
+  close_fd(err[1]);
+  stdin_fd_ = in[1];
+  primary_fd_ = opt.primary == Stream::Out ? out[0] : err[0];
+  capture_fd_ = opt.primary == Stream::Out ? err[0] : out[0];
+  for (int fd : {stdin_fd_, primary_fd_, capture_fd_}) {
+    if (fd >= 0) set_nonblocking(fd);
+  }
+  grow_pipe(primary_fd_, opt.pipe_size);
+  grow_pipe(capture_fd_, opt.pipe_size);
+  return true;
+}
+
+// ============================================================================
+// I/O
+// ============================================================================
+
+void Subprocess::drain_capture() {
+  char chunk[4096];
+  while (capture_fd_ >= 0) {
+    ssize_t n = ::read(capture_fd_, chunk, sizeof(chunk));
+    if (n > 0) {
+      captured_.append(chunk, (size_t)n);
+      continue;
+    }
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && errno == EAGAIN) return;
+    close_fd(capture_fd_);  // EOF or error
+  }
+}
+
+ssize_t Subprocess::read(char* buf, size_t n) {
+  using clock = std::chrono::steady_clock;
+  const clock::time_point deadline = clock::now() + std::chrono::milliseconds(read_timeout_ms_);
+  for (;;) {
+    if (primary_fd_ < 0) return 0;
+    ssize_t r = ::read(primary_fd_, buf, n);
+    if (r > 0) return r;
+    if (r == 0) {
+      close_fd(primary_fd_);
+      eof_ = true;
+      return 0;
+    }
+    if (errno == EINTR) continue;
+    if (errno != EAGAIN) {
+      error_ = std::string("read: ") + std::strerror(errno);
+      close_fd(primary_fd_);
+      return -1;
+    }
+
+    // Nothing buffered: sleep until either stream moves, interrupt() or
+    // the deadline (a child that stops writing without exiting)
+    int wait_ms = -1;
+    if (read_timeout_ms_ > 0) {
+      const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now());
+      if (left.count() <= 0) {
+        timed_out_ = true;
+        error_ = "read timed out";
+        return -1;
+      }
+      wait_ms = (int)left.count();
+    }
+    struct pollfd fds[3] = {{primary_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0},
+                            {capture_fd_, POLLIN, 0}};
+    if (::poll(fds, capture_fd_ >= 0 ? 3 : 2, wait_ms) < 0 && errno != EINTR) {
+      error_ = std::string("poll: ") + std::strerror(errno);
+      return -1;
+    }
+    if (fds[1].revents) {
+      uint64_t count;
+      (void)!::read(wake_fd_, &count, sizeof(count));
+      error_ = "interrupted";
+      return -1;
+    }
+    if (capture_fd_ >= 0 && fds[2].revents) drain_capture();
+  }
+}
+
+void Subprocess::interrupt() {
+  // eventfd writes are atomic, so this is safe from any thread
+  if (wake_fd_ >= 0) {
+    uint64_t one = 1;
+    (void)!::write(wake_fd_, &one, sizeof(one));
+  }
+}
+
+bool Subprocess::write_all(const void* data, size_t n) {
+  const char* p = static_cast<const char*>(data);
+  while (n > 0) {
+    if (stdin_fd_ < 0) return false;
+    ssize_t w = ::write(stdin_fd_, p, n);
+    if (w > 0) {
+      p += w;
+      n -= (size_t)w;
+      continue;
+    }
+    if (w < 0 && errno == EINTR) continue;
+    if (w < 0 && errno == EAGAIN) {
+      struct pollfd pfd = {stdin_fd_, POLLOUT, 0};
+      ::poll(&pfd, 1, -1);
+      continue;
+    }
+    error_ = std::string("write: ") + std::strerror(errno);
+    close_fd(stdin_fd_);
+    return false;
+  }
+  return true;
+}
+
+void Subprocess::close_stdin() { close_fd(stdin_fd_); }
+
+// ============================================================================
+// Teardown
+// ============================================================================
+
+void Subprocess::close_fds() {
+  drain_capture();
+  close_fd(stdin_fd_);
+  close_fd(primary_fd_);
+  close_fd(capture_fd_);
+}
+
+bool Subprocess::reap(int options) {
+  for (;;) {
+    int st = 0;
+    pid_t r = ::waitpid(pid_, &st, options);
+    if (r == pid_) {
+      status_ = st;
+      status_valid_ = true;
+      pid_ = -1;
+      return true;
+    }
+    if (r < 0 && errno == EINTR) continue;
+    if (r < 0) {  // ECHILD: reaped elsewhere
+      error_ = std::string("waitpid: ") + std::strerror(errno);
+      pid_ = -1;
+      return true;
+    }
+    return false;  // WNOHANG and still running
+  }
+}
+
+bool Subprocess::finish(int timeout_ms) {
+  close_fds();
+  if (pid_ <= 0) return true;
+
+  // A child still writing gets SIGPIPE now that the pipes are closed
+  using clock = std::chrono::steady_clock;
+  const auto deadline = clock::now() + std::chrono::milliseconds(timeout_ms);
+  auto nap = std::chrono::microseconds(20);
+  for (;;) {
+    if (reap(WNOHANG)) return true;
+    if (clock::now() >= deadline) break;
+    std::this_thread::sleep_for(nap);
+    if (nap < std::chrono::milliseconds(2)) nap *= 2;
+  }
+  terminate();
+  return false;
+}
+
+void Subprocess::terminate() {
+  close_fds();
+  if (pid_ <= 0) return;
+  ::kill(pid_, SIGKILL);
+  reap(0);
+}
+
+void Subprocess::kill_async(int deadline_ms) {
+  close_fds();
+  if (pid_ <= 0) return;
+  ::kill(pid_, SIGKILL);
+  if (!reap(WNOHANG)) {
+    std::lock_guard<std::mutex> lock(g_abandoned_mutex);
+    g_abandoned.push_back({pid_, std::chrono::steady_clock::now() +
+                                     std::chrono::milliseconds(deadline_ms)});
+    pid_ = -1;
+  }
+  reap_abandoned();
+}
@@ -0,0 +1,190 @@
+#include "TraceFile.hpp"
+#include "SpikeLogParser.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+bool read_file(const std::string& path, std::string& out, std::string& error) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    error = path + ": " + std::strerror(errno);
+    return false;
+  }
+  struct stat st;
+  out.clear();
+  if (::fstat(fd, &st) == 0 && st.st_size > 0) out.reserve((size_t)st.st_size);
+  char buf[65536];
+  for (;;) {
+    ssize_t n = ::read(fd, buf, sizeof(buf));
+    if (n > 0) {
+      out.append(buf, (size_t)n);
+      continue;
+    }
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) error = path + ": " + std::strerror(errno);
+    break;
+  }
+  ::close(fd);
+  return error.empty();
+}
+
+// Memory-op kind of a load/store encoding (RV32I/A and the C quadrants)
+void classify_mem_op(CommitRec& rec) {
+  const uint32_t insn = rec.insn;
+  bool load = false, store = false;
+  if ((insn & 3) == 3) {
+    const uint32_t opcode = insn & 0x7f;
+    load = opcode == 0x03;
+    store = opcode == 0x23;
+    if (opcode == 0x2f) {  // AMO: LR loads, SC stores, the rest do both
+      const uint32_t funct5 = insn >> 27;
+      load = funct5 != 0x03;
+      store = funct5 != 0x02;
+    }
+  } else {
+    const uint32_t funct3 = (insn >> 13) & 7;
+    const uint32_t quadrant = insn & 3;
+    load = (quadrant == 0 || quadrant == 2) && funct3 == 2;   // c.lw, c.lwsp
+    store = (quadrant == 0 || quadrant == 2) && funct3 == 6;  // c.sw, c.swsp
+  }
+  rec.mem_is_load = load;
+  rec.mem_is_store = store;
+}
+
+} // namespace
+
+bool TraceFile::load(const std::string& path) {
+  commits_.clear();
+  finished_ = false;
+  error_.clear();
+  std::string data;
+  if (!read_file(path, data, error_)) return false;
+
+  if (data.size() >= sizeof(trace_format::kMagic) &&
+      std::memcmp(data.data(), trace_format::kMagic, sizeof(trace_format::kMagic)) == 0) {
+    format_ = Format::Binary;
+    return parse_binary(data);
+  }
+  const size_t first = data.find_first_not_of(" \t\r\n");
+  if (first != std::string::npos &&
+      (data.compare(first, 5, "#pc_r") == 0 || data.compare(first, 2, "0x") == 0)) {
+    format_ = Format::Csv;
+    parse_csv(data);
+  } else {
+    format_ = Format::SpikeLog;
+    parse_spike_log(data);
+  }
+  return true;
+}
+
+bool TraceFile::parse_binary(const std::string& data) {
+  trace_format::Header h;
+  if (data.size() < sizeof(h)) {
+    error_ = "truncated binary trace header";
+    return false;
+  }
+  std::memcpy(&h, data.data(), sizeof(h));
+  if (!trace_format::valid_header(h)) {
+    error_ = "unsupported binary trace (version " + std::to_string(h.version) +
+             ", record size " + std::to_string(h.record_bytes) + ")";
+    return false;
+  }
+  // A torn last record (writer killed mid-write) is dropped
+  const size_t n = (data.size() - sizeof(h)) / trace_format::kRecordBytes;
+  commits_.resize(n);
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(data.data()) + sizeof(h);
+  for (size_t i = 0; i < n; ++i, p += trace_format::kRecordBytes) {
+    trace_format::unpack(p, commits_[i]);
+  }
+  finished_ = (h.flags & trace_format::kFlagFinished) != 0;
+  return true;
+}
+
+void TraceFile::parse_csv(const std::string& data) {
+  // pc_r,pc_w,insn,rd_addr,rd_wdata,mem_addr,mem_rmask,mem_wmask,trap
+  const char* p = data.c_str();
+  while (*p) {
+    const char* eol = std::strchr(p, '\n');
+    if (!eol) eol = p + std::strlen(p);
+    if (*p != '#' && p != eol) {
+      uint32_t v[9];
+      int n = 0;
+      const char* q = p;
+      for (; n < 9 && q < eol; ++n) {
+        char* end;
+        v[n] = (uint32_t)std::strtoul(q, &end, 0);  // 0x.. hex, plain decimal
+        if (end == q) break;
+        q = end < eol && *end == ',' ? end + 1 : end;
+      }
+      if (n == 9) {
+        CommitRec rec;
+        rec.pc_r = v[0];      rec.pc_w = v[1];      rec.insn = v[2];
+        rec.rd_addr = v[3];   rec.rd_wdata = v[4];  rec.mem_addr = v[5];
+        rec.mem_rmask = v[6]; rec.mem_wmask = v[7]; rec.trap = v[8];
+        if (rec.mem_rmask || rec.mem_wmask) {
+          rec.mem_is_load = rec.mem_rmask != 0;
+          rec.mem_is_store = rec.mem_wmask != 0;
+        } else if (rec.mem_addr) {
+          classify_mem_op(rec);
+        }
+        commits_.push_back(rec);
+      }
+    }
+    p = *eol ? eol + 1 : eol;
+  }
+  finished_ = true;
+}
+
+void TraceFile::parse_spike_log(const std::string& data) {
+  size_t pos = 0;
+  SpikeLogParser parser;
+  parser.reset([&data, &pos](char* buf, size_t n) -> ssize_t {
+    n = std::min(n, data.size() - pos);
+    std::memcpy(buf, data.data() + pos, n);
+    pos += n;
+    return (ssize_t)n;
+  });
+  CommitRec rec;
+  SpikeLogParser::Event ev;
+  while ((ev = parser.next(rec)) == SpikeLogParser::Event::Commit) {
+    commits_.push_back(rec);
+  }
+  finished_ = ev == SpikeLogParser::Event::End;
+}
+
+bool TraceFile::save(const std::string& path, const std::vector<CommitRec>& commits,
+                     bool finished) {
+  // Several fuzzer instances (or batch workers) may record the same input at once
+  static std::atomic<unsigned> seq{0};
+  const std::string tmp = path + ".tmp." + std::to_string(::getpid()) + "." +
+                          std::to_string(seq.fetch_add(1));
+  int fd = ::open(tmp.c_str(), O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) return false;
+
+  std::vector<uint8_t> buf(sizeof(trace_format::Header) +
+                           commits.size() * trace_format::kRecordBytes);
+  const trace_format::Header h =
+      trace_format::make_header(finished ? (uint32_t)trace_format::kFlagFinished : 0u);
+  std::memcpy(buf.data(), &h, sizeof(h));
+  uint8_t* p = buf.data() + sizeof(h);
+  for (const CommitRec& rec : commits) {
+    trace_format::pack(rec, p);
+    p += trace_format::kRecordBytes;
+  }
+  utils::safe_write_all(fd, buf.data(), buf.size());
+  const bool ok = ::lseek(fd, 0, SEEK_CUR) == (off_t)buf.size();
+  ::close(fd);
+  if (!ok || ::rename(tmp.c_str(), path.c_str()) != 0) {
+    ::unlink(tmp.c_str());
+    return false;
+  }
+  return true;
+}
@@ -67,11 +67,12 @@ Options:
       --afl-debug             Enable AFL++ debug output (AFL_DEBUG=1) - very verbose
       --ui-mode MODE          AFL++ UI mode: auto (default) | on | off
       --max-cycles N          Pass MAX_CYCLES to harness
-      --golden MODE           GOLDEN_MODE = live | off | batch | replay (default: live)
+      --golden MODE           GOLDEN_MODE = live | builtin | off | batch | replay (default: live)
       --spike PATH            Path to Spike binary (SPIKE_BIN)
       --objcopy PATH          Path to objcopy (OBJCOPY_BIN)
       --isa STR               Spike ISA string, e.g., rv32imc (SPIKE_ISA)
-      --trace-mode on|off     Enable/disable harness trace writing (default: on)
+      --trace-mode MODE       TRACE_MODE = on | off | ring (default: on); ring writes
+                              traces of the last TRACE_RING commits only for findings
       --exec-backend B        EXEC_BACKEND = verilator | fpga (default: verilator)
   -h, --help                  Show this help and exit
 
@@ -221,11 +222,14 @@ export SCHEMA_DIR="${SCHEMA_DIR:-$PROJECT_ROOT/schemas}"
 # Propagate crash directory to harness using the name it expects
 export CRASH_LOG_DIR="$CRASH_DIR"
 export SPIKE_LOG_FILE
+export SPIKE_LOG_RING="${SPIKE_LOG_RING:-256}"
+export SPIKE_LOG_SAMPLE="${SPIKE_LOG_SAMPLE:-0}"
 export LINKER_SCRIPT="${LINKER_SCRIPT:-$PROJECT_ROOT/tools/link.ld}"
 
 # Golden/trace/backend defaults (from fuzzer.env or CLI overrides)
 export GOLDEN_MODE="${GOLDEN_MODE:-live}"
 export TRACE_MODE="${TRACE_MODE:-on}"
+export TRACE_RING="${TRACE_RING:-1024}"
 export EXEC_BACKEND="${EXEC_BACKEND:-verilator}"
 
 # Tooling paths (defaults from fuzzer.env)
@@ -234,13 +238,30 @@ export SPIKE_ISA="${SPIKE_ISA:-rv32im}"
 export OBJCOPY_BIN="${OBJCOPY_BIN:-/opt/riscv/bin/riscv32-unknown-elf-objcopy}"
 export OBJDUMP_BIN="${OBJDUMP_BIN:-/opt/riscv/bin/riscv32-unknown-elf-objdump}"
 export LD_BIN="${LD_BIN:-/opt/riscv/bin/riscv32-unknown-elf-ld}"
+export SPIKE_ELF_BUILDER="${SPIKE_ELF_BUILDER:-native}"
+export GOLDEN_KILL_TIMEOUT_MS="${GOLDEN_KILL_TIMEOUT_MS:-100}"
+export GOLDEN_STALL_TIMEOUT_MS="${GOLDEN_STALL_TIMEOUT_MS:-$((10 * GOLDEN_KILL_TIMEOUT_MS))}"
+export GOLDEN_ASYNC="${GOLDEN_ASYNC:-0}"
+export GOLDEN_CACHE="${GOLDEN_CACHE:-}"
+export GOLDEN_CACHE_MB="${GOLDEN_CACHE_MB:-256}"
+export GOLDEN_BATCH_BACKEND="${GOLDEN_BATCH_BACKEND:-live}"
+export GOLDEN_REPLAY="${GOLDEN_REPLAY:-}"
+export GOLDEN_RECORD="${GOLDEN_RECORD:-}"
+BATCH_JOBS="${BATCH_JOBS:-1}"
 export PC_STAGNATION_LIMIT="${PC_STAGNATION_LIMIT:-512}"
 export MAX_PROGRAM_WORDS="${MAX_PROGRAM_WORDS:-256}"
 export STOP_ON_SPIKE_DONE="${STOP_ON_SPIKE_DONE:-1}"
 export APPEND_EXIT_STUB="${APPEND_EXIT_STUB:-1}"
 
-# Check if golden mode is enabled and enforce tool requirements
-if [[ "$GOLDEN_MODE" != "off" ]]; then
+# GOLDEN_MODE=batch fuzzes the DUT alone; batch_picorv32 --watch checks new
+# queue entries with GOLDEN_BATCH_BACKEND, which decides the tools needed
+GOLDEN_CHECK_MODE="$GOLDEN_MODE"
+if [[ "$GOLDEN_MODE" == "batch" ]]; then GOLDEN_CHECK_MODE="$GOLDEN_BATCH_BACKEND"; fi
+
+# Check if golden mode needs Spike and enforce tool requirements
+# (builtin runs the in-process RV32IM model and replay reads recorded
+# traces; neither needs the RISC-V tools)
+if [[ "$GOLDEN_CHECK_MODE" != "off" && "$GOLDEN_CHECK_MODE" != "builtin" && "$GOLDEN_CHECK_MODE" != "replay" ]]; then
   # SPIKE_BIN is required for golden mode
   if ! command -v "$SPIKE_BIN" >/dev/null 2>&1; then
     log "[!] ERROR: SPIKE_BIN not found at '$SPIKE_BIN' and not on PATH." >&2
@@ -249,47 +270,56 @@ if [[ "$GOLDEN_MODE" != "off" ]]; then
     exit 1
   fi
   
-  # OBJCOPY_BIN is required for converting .bin to .elf
-  if ! command -v "$OBJCOPY_BIN" >/dev/null 2>&1; then
-    # Try 64-bit fallback
-    if command -v riscv64-unknown-elf-objcopy >/dev/null 2>&1; then
-      log "[INFO] Using riscv64-unknown-elf-objcopy as fallback"
-      OBJCOPY_BIN="riscv64-unknown-elf-objcopy"
-    else
-      log "[!] ERROR: OBJCOPY_BIN '$OBJCOPY_BIN' not found and no 64-bit fallback available." >&2
-      log "    Golden mode requires objcopy to convert .bin files to .elf for Spike." >&2
-      exit 1
+  # objcopy + ld are only used when SPIKE_ELF_BUILDER=toolchain; by default
+  # the harness writes the Spike ELF itself
+  if [[ "$SPIKE_ELF_BUILDER" == "toolchain" ]]; then
+    # OBJCOPY_BIN is required for converting .bin to .elf
+    if ! command -v "$OBJCOPY_BIN" >/dev/null 2>&1; then
+      # Try 64-bit fallback
+      if command -v riscv64-unknown-elf-objcopy >/dev/null 2>&1; then
+        log "[INFO] Using riscv64-unknown-elf-objcopy as fallback"
+        OBJCOPY_BIN="riscv64-unknown-elf-objcopy"
+      else
+        log "[!] ERROR: OBJCOPY_BIN '$OBJCOPY_BIN' not found and no 64-bit fallback available." >&2
+        log "    Golden mode requires objcopy to convert .bin files to .elf for Spike." >&2
+        exit 1
+      fi
     fi
-  fi
 
-  if ! command -v "$LD_BIN" >/dev/null 2>&1; then
-    if command -v riscv32-unknown-elf-ld >/dev/null 2>&1; then
-      LD_BIN="riscv32-unknown-elf-ld"
-    elif command -v riscv64-unknown-elf-ld >/dev/null 2>&1; then
-      log "[INFO] Using riscv64-unknown-elf-ld as fallback"
-      LD_BIN="riscv64-unknown-elf-ld"
-    else
-      log "[!] ERROR: LD_BIN '$LD_BIN' not found and no fallback available." >&2
-      log "    Golden mode requires a RISC-V linker to wrap Spike inputs." >&2
-      exit 1
+    if ! command -v "$LD_BIN" >/dev/null 2>&1; then
+      if command -v riscv32-unknown-elf-ld >/dev/null 2>&1; then
+        LD_BIN="riscv32-unknown-elf-ld"
+      elif command -v riscv64-unknown-elf-ld >/dev/null 2>&1; then
+        log "[INFO] Using riscv64-unknown-elf-ld as fallback"
+        LD_BIN="riscv64-unknown-elf-ld"
+      else
+        log "[!] ERROR: LD_BIN '$LD_BIN' not found and no fallback available." >&2
+        log "    Golden mode requires a RISC-V linker to wrap Spike inputs." >&2
+        exit 1
+      fi
     fi
   fi
 else
-  # Golden mode is off, tools are optional
+  # Golden mode is off, builtin or replay, tools are optional
   if ! command -v "$SPIKE_BIN" >/dev/null 2>&1; then
-    log "[INFO] SPIKE_BIN not found (golden mode is off, this is OK)"
+    log "[INFO] SPIKE_BIN not found (golden mode is $GOLDEN_MODE, this is OK)"
     unset SPIKE_BIN
   fi
   if ! command -v "$OBJCOPY_BIN" >/dev/null 2>&1; then
-    log "[INFO] OBJCOPY_BIN not found (golden mode is off, this is OK)"
+    log "[INFO] OBJCOPY_BIN not found (golden mode is $GOLDEN_MODE, this is OK)"
     unset OBJCOPY_BIN
   fi
   if ! command -v "$LD_BIN" >/dev/null 2>&1; then
-    log "[INFO] LD_BIN not found (golden mode is off, this is OK)"
+    log "[INFO] LD_BIN not found (golden mode is $GOLDEN_MODE, this is OK)"
     unset LD_BIN
   fi
 fi
 
+if [[ "$GOLDEN_CHECK_MODE" == "replay" && ! -e "$GOLDEN_REPLAY" ]]; then
+  log "[!] ERROR: GOLDEN_MODE=replay needs GOLDEN_REPLAY (a GOLDEN_RECORD directory or a trace file)." >&2
+  exit 1
+fi
+
 # Export detected/provided tooling
 if [[ -n "${SPIKE_BIN:-}" ]];   then export SPIKE_BIN; fi
 if [[ -n "${SPIKE_ISA:-}" ]];   then export SPIKE_ISA; fi
@@ -299,7 +329,7 @@ if [[ -n "${LD_BIN:-}" ]];      then export LD_BIN; fi
 export PC_STAGNATION_LIMIT MAX_PROGRAM_WORDS STOP_ON_SPIKE_DONE APPEND_EXIT_STUB
 
 # Preserve these env vars in the target (space-separated list for AFL++)
-export AFL_KEEP_ENV="CRASH_LOG_DIR MAX_CYCLES DEBUG GOLDEN_MODE EXEC_BACKEND TRACE_MODE SPIKE_BIN SPIKE_ISA OBJCOPY_BIN OBJDUMP_BIN LD_BIN SPIKE_LOG_FILE LINKER_SCRIPT TOHOST_ADDR PC_STAGNATION_LIMIT MAX_PROGRAM_WORDS STOP_ON_SPIKE_DONE APPEND_EXIT_STUB RAM_BASE RAM_SIZE PROGADDR_RESET PROGADDR_IRQ STACK_ADDR STACKADDR MUTATOR_CONFIG SCHEMA_DIR"
+export AFL_KEEP_ENV="CRASH_LOG_DIR MAX_CYCLES DEBUG GOLDEN_MODE EXEC_BACKEND TRACE_MODE SPIKE_BIN SPIKE_ISA OBJCOPY_BIN OBJDUMP_BIN LD_BIN SPIKE_LOG_FILE SPIKE_LOG_RING SPIKE_LOG_SAMPLE LINKER_SCRIPT TOHOST_ADDR PC_STAGNATION_LIMIT MAX_PROGRAM_WORDS STOP_ON_SPIKE_DONE APPEND_EXIT_STUB RAM_BASE RAM_SIZE PROGADDR_RESET PROGADDR_IRQ STACK_ADDR STACKADDR MUTATOR_CONFIG SCHEMA_DIR UART_ADDR TIMER_ADDR SPIKE_ELF_BUILDER GOLDEN_KILL_TIMEOUT_MS GOLDEN_STALL_TIMEOUT_MS GOLDEN_ASYNC GOLDEN_CACHE GOLDEN_CACHE_MB GOLDEN_REPLAY GOLDEN_RECORD TRACE_RING"
 
 # Optional AFL debug output (very verbose - separate from mutator/harness DEBUG)
 if [[ "$AFL_DEBUG" == "1" ]]; then
@@ -370,7 +400,7 @@ cat <<BANNER
   IRQ Vector   : $PROGADDR_IRQ
   Stack Addr   : $STACK_ADDR
   Extra AFL    : ${AFL_EXTRA_ARGS:-<none>}
-  Golden Mode  : $GOLDEN_MODE
+  Golden Mode  : $GOLDEN_MODE$([ "$GOLDEN_MODE" == "batch" ] && echo " ($GOLDEN_BATCH_BACKEND, $BATCH_JOBS watcher core(s))")
   Exec Backend : $EXEC_BACKEND
   Trace Mode   : $TRACE_MODE
   Crash Logs   : $CRASH_DIR
@@ -426,6 +456,27 @@ fi
 if [[ "$NO_BUILD" -eq 0 ]]; then
   log "[BUILD] Building mutator + harness..."
   make -C "$AFL_DIR" build
+  if [[ "$GOLDEN_MODE" == "batch" ]]; then
+    make -C "$AFL_DIR" batch
+  fi
+fi
+
+# ---------- Offline golden checks (GOLDEN_MODE=batch) ----------
+BATCH_PID=""
+stop_batch_watcher() {
+  if [[ -n "$BATCH_PID" ]]; then
+    kill -TERM "$BATCH_PID" 2>/dev/null || true
+    wait "$BATCH_PID" 2>/dev/null || true
+    BATCH_PID=""
+  fi
+}
+if [[ "$GOLDEN_MODE" == "batch" ]]; then
+  BATCH_LOG="${RUN_DIR}/batch_watch.log"
+  log "[BATCH] Checking new queue entries with $GOLDEN_BATCH_BACKEND on $BATCH_JOBS core(s); log: $BATCH_LOG"
+  "$AFL_DIR/batch_picorv32" --watch -j "$BATCH_JOBS" --state "${RUN_DIR}/batch_watch.state" \
+    "$CORPORA_DIR" >> "$BATCH_LOG" 2>&1 &
+  BATCH_PID=$!
+  trap stop_batch_watcher EXIT
 fi
 
 # ---------- Launch AFL++ ----------
@@ -451,15 +502,17 @@ else
   # shellcheck disable=SC2086
   MAIN_LOG="${RUN_DIR}/main.log"
   "${AFL_BASE[@]}" -M main $AFL_EXTRA_ARGS "${TARGET[@]}" 2>&1 | tee "$MAIN_LOG" &
+  AFL_PIDS=($!)
   sleep 2
   for i in $(seq 1 $((CORES - 1))); do
     echo "[SLAVE $i] Starting worker..."
     # shellcheck disable=SC2086
     SLAVE_LOG_FILE="${RUN_DIR}/fuzz_slave${i}.log"
     "${AFL_BASE[@]}" -S "slave$i" $AFL_EXTRA_ARGS "${TARGET[@]}" >> "$SLAVE_LOG_FILE" 2>&1 &
+    AFL_PIDS+=($!)
     sleep 2
   done
-  wait
+  wait "${AFL_PIDS[@]}"
   # Concatenate logs into LOG_FILE for summary (handle case with no slaves)
   if ls "${RUN_DIR}/fuzz_slave"*.log >/dev/null 2>&1; then
     cat "$MAIN_LOG" "${RUN_DIR}/fuzz_slave"*.log > "$LOG_FILE"
@@ -468,6 +521,8 @@ else
   fi
 fi
 
+stop_batch_watcher
+
 log "=========================================================="
 log "  ✅ AFL++ session complete."
 log "  Logs stored in: $LOG_FILE"
@@ -0,0 +1,59 @@
+#!/usr/bin/env bash
+# ==========================================================
+# bench_exec_overhead.sh — Per-input harness overhead
+# Usage:
+#   ./tools/bench_exec_overhead.sh <seed.bin> [runs=50]
+# Runs the harness <runs> times on one seed (one process per input, i.e. the
+# cost AFL++ paid before the deferred forkserver) and then reports the
+# one-time setup and per-input times the harness logs to runtime.log.
+# Optional env:
+#   GOLDEN_MODE=off (default here, so Spike start-up is not measured)
+#   TRACE_MODE=off  (default here)
+# ==========================================================
+set -euo pipefail
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+HARNESS="$ROOT/afl/afl_picorv32"
+SEED="${1:-}"
+RUNS="${2:-50}"
+if [[ -z "$SEED" || ! -f "$SEED" ]]; then
+  echo "Usage: $0 <seed.bin> [runs]" >&2
+  exit 2
+fi
+if [[ ! -x "$HARNESS" ]]; then
+  echo "Harness not built: $HARNESS (run make -C afl)" >&2
+  exit 2
+fi
+
+RUN_DIR="$(mktemp -d "${TMPDIR:-/tmp}/bench_exec.XXXXXX")"
+trap 'rm -rf "$RUN_DIR"' EXIT
+
+export PROJECT_ROOT="$RUN_DIR"
+export GOLDEN_MODE="${GOLDEN_MODE:-off}"
+export TRACE_MODE="${TRACE_MODE:-off}"
+source "$ROOT/tools/memory_env.sh"
+# The harness reads {PROJECT_ROOT}/afl_harness/harness.conf and logs to
+# {PROJECT_ROOT}/workdir/logs, so give it a private copy of the config
+mkdir -p "$RUN_DIR/afl_harness"
+cp "$ROOT/afl_harness/harness.conf" "$RUN_DIR/afl_harness/"
+
+START_NS=$(date +%s%N)
+for ((i = 0; i < RUNS; i++)); do
+  "$HARNESS" "$SEED" >/dev/null 2>&1 || true
+done
+END_NS=$(date +%s%N)
+
+LOG="$RUN_DIR/workdir/logs/runtime.log"
+# Average of the number captured by a sed pattern over all log lines
+avg_of() {
+  sed -n "s/$1/\\1/p" "$LOG" 2>/dev/null | awk '{ s += $1; n++ } END { if (n) printf "%.0f", s / n; else print "n/a" }'
+}
+
+echo "=========================================================="
+echo "  Runs                 : $RUNS"
+echo "  Wall time per exec   : $(( (END_NS - START_NS) / RUNS / 1000 )) us"
+echo "  One-time setup (avg) : $(avg_of '.*setup took \([0-9]*\) us.*') us"
+echo "  Per-input run  (avg) : $(avg_of '.*, \([0-9]*\) us per input.*') us"
+echo "=========================================================="
+echo "  Wall time per exec minus per-input run approximates the"
+echo "  fork + setup cost that __AFL_INIT() removes under afl-fuzz."
@@ -0,0 +1,216 @@
+// ==========================================================
+// bench_spike_parser.cpp — Spike log parsing throughput, regex vs SpikeLogParser
+// Build:  make -C afl bench-parser
+// Usage:  afl/bench_spike_parser [spike.log] [repeat=20]
+// Parses a recorded `spike -l` log (or a synthetic one when no file is given)
+// with the old std::getline + std::regex loop and with SpikeLogParser,
+// checks both produce the same CommitRecs and reports lines/sec for each.
+// ==========================================================
+
+#include "SpikeLogParser.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// Copy of SpikeProcess::next_commit() before SpikeLogParser, minus the
+// process handling and raw log output
+class LegacyParser {
+public:
+  explicit LegacyParser(std::istream& in) : in_(in) {}
+
+  bool next(CommitRec& rec) {
+    static const std::regex commit_re("core\\s+0:\\s+0x([0-9a-fA-F]+)\\s+\\(0x([0-9a-fA-F]+)\\)");
+    static const std::regex reg_write_re("\\b(W|W0|W1)\"?\\s*x([0-9]+)\\s*[:<=-]+\\s*0x([0-9a-fA-F]+)");
+    static const std::regex simple_reg_re("\\bx([0-9]+)\\)\\s*:=\\s*0x([0-9a-fA-F]+)");
+    static const std::regex mem_store_re("\\bmem\\s*\\[?0x([0-9a-fA-F]+)\\]?\\s*(?:=|<-|:)\\s*0x([0-9a-fA-F]+)");
+    static const std::regex mem_load_re ("\\bmem\\s*\\[?0x([0-9a-fA-F]+)\\]?\\s*(?:->|=>)\\s*0x([0-9a-fA-F]+)");
+    for (;;) {
+      std::string s;
+      if (!pending_.empty()) {
+        s.swap(pending_);
+      } else {
+        if (!std::getline(in_, s)) return false;
+        s.push_back('\n');
+      }
+      if (s.find("exception") != std::string::npos && s.find("core") != std::string::npos) {
+        return false;
+      }
+      std::smatch m;
+      if (!std::regex_search(s, m, commit_re)) continue;
+
+      std::vector<std::string> chunk;
+      {
+        std::ostringstream hdr;
+        hdr << "----- SPIKE INSTR #" << (++index_)
+            << " pc=0x" << std::hex << m[1].str() << " insn=0x" << m[2].str() << " -----\n";
+        chunk.push_back(hdr.str());
+      }
+      chunk.push_back(s);
+      rec = CommitRec();
+      rec.pc_w = (uint32_t)std::stoul(m[1].str(), nullptr, 16);
+      rec.insn = (uint32_t)std::stoul(m[2].str(), nullptr, 16);
+      for (int i = 0; i < 16; ++i) {
+        std::string s2;
+        if (!std::getline(in_, s2)) break;
+        s2.push_back('\n');
+        std::smatch mnext;
+        if (std::regex_search(s2, mnext, commit_re)) {
+          pending_ = s2;
+          break;
+        }
+        chunk.push_back(s2);
+        std::smatch mr;
+        if (std::regex_search(s2, mr, simple_reg_re)) {
+          rec.rd_addr = std::stoi(mr[1].str());
+          rec.rd_wdata = (uint32_t)std::stoul(mr[2].str(), nullptr, 16);
+        } else if (std::regex_search(s2, mr, reg_write_re)) {
+          rec.rd_addr = std::stoi(mr[2].str());
+          rec.rd_wdata = (uint32_t)std::stoul(mr[3].str(), nullptr, 16);
+        } else if (std::regex_search(s2, mr, mem_store_re)) {
+          rec.mem_addr = (uint32_t)std::stoul(mr[1].str(), nullptr, 16);
+          rec.mem_wdata = (uint32_t)std::stoul(mr[2].str(), nullptr, 16);
+          rec.mem_is_store = 1;
+        } else if (std::regex_search(s2, mr, mem_load_re)) {
+          rec.mem_addr = (uint32_t)std::stoul(mr[1].str(), nullptr, 16);
+          rec.mem_rdata = (uint32_t)std::stoul(mr[2].str(), nullptr, 16);
+          rec.mem_is_load = 1;
+        }
+        if (s2.size() <= 1) break;
+      }
+      return true;
+    }
+  }
+
+private:
+  std::istream& in_;
+  std::string pending_;
+  size_t index_ = 0;
+};
+
+// Commit-log shapes Spike prints for ALU ops, loads and stores
+std::string synthesize_log(size_t commits) {
+  std::string log = "bbl loader\n";
+  char line[160];
+  uint32_t pc = 0x80000000;
+  for (size_t i = 0; i < commits; ++i, pc += 4) {
+    switch (i % 4) {
+      case 0:
+        std::snprintf(line, sizeof(line),
+                      "core   0: 0x%08x (0x00a50533) add     a0, a0, a0\n"
+                      "core   0: 3 0x%08x (0x00a50533) x10 0x%08x\n",
+                      pc, pc, (uint32_t)(i * 2654435761u));
+        break;
+      case 1:
+        std::snprintf(line, sizeof(line),
+                      "core   0: 0x%08x (0x00b585b3) add     a1, a1, a1\n"
+                      "  W x11 <- 0x%08x\n",
+                      pc, (uint32_t)(i * 2654435761u));
+        break;
+      case 2:
+        std::snprintf(line, sizeof(line),
+                      "core   0: 0x%08x (0x0005a503) lw      a0, 0(a1)\n"
+                      "  mem [0x%08x] -> 0x%08x\n",
+                      pc, 0x80040000u + (uint32_t)(i & 0xfff) * 4, (uint32_t)i);
+        break;
+      default:
+        std::snprintf(line, sizeof(line),
+                      "core   0: 0x%08x (0x00a5a023) sw      a0, 0(a1)\n"
+                      "  mem [0x%08x] = 0x%08x\n",
+                      pc, 0x80040000u + (uint32_t)(i & 0xfff) * 4, (uint32_t)i);
+        break;
+    }
+    log += line;
+  }
+  return log;
+}
+
+bool same(const CommitRec& a, const CommitRec& b) {
+  return a.pc_w == b.pc_w && a.insn == b.insn && a.rd_addr == b.rd_addr &&
+         a.rd_wdata == b.rd_wdata && a.mem_addr == b.mem_addr &&
+         a.mem_is_load == b.mem_is_load && a.mem_is_store == b.mem_is_store &&
+         a.mem_wdata == b.mem_wdata && a.mem_rdata == b.mem_rdata;
+}
+
+std::vector<CommitRec> run_legacy(const std::string& log) {
+  std::istringstream in(log);
+  LegacyParser parser(in);
+  std::vector<CommitRec> out;
+  CommitRec rec;
+  while (parser.next(rec)) out.push_back(rec);
+  return out;
+}
+
+// Reads a file descriptor, as SpikeProcess does with the Spike pipe
+std::vector<CommitRec> run_streaming(const std::string& log) {
+  FILE* tmp = std::tmpfile();
+  std::fwrite(log.data(), 1, log.size(), tmp);
+  std::fflush(tmp);
+  ::lseek(fileno(tmp), 0, SEEK_SET);
+
+  SpikeLogParser parser;
+  parser.reset(fileno(tmp));
+  std::vector<CommitRec> out;
+  CommitRec rec;
+  while (parser.next(rec) == SpikeLogParser::Event::Commit) out.push_back(rec);
+  std::fclose(tmp);
+  return out;
+}
+
+template <typename F>
+double seconds(F&& f, int repeat) {
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeat; ++i) f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::string log;
+  if (argc > 1) {
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in) {
+      std::fprintf(stderr, "cannot open %s\n", argv[1]);
+      return 2;
+    }
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    log = ss.str();
+  } else {
+    log = synthesize_log(200000);
+  }
+  const int repeat = argc > 2 ? std::atoi(argv[2]) : 20;
+  size_t lines = 0;
+  for (char c : log) lines += c == '\n';
+
+  auto legacy = run_legacy(log);
+  auto streaming = run_streaming(log);
+  if (legacy.size() != streaming.size()) {
+    std::fprintf(stderr, "MISMATCH: %zu vs %zu commits\n", legacy.size(), streaming.size());
+    return 1;
+  }
+  for (size_t i = 0; i < legacy.size(); ++i) {
+    if (!same(legacy[i], streaming[i])) {
+      std::fprintf(stderr, "MISMATCH at commit %zu (pc=0x%08x)\n", i, legacy[i].pc_w);
+      return 1;
+    }
+  }
+
+  const double t_legacy = seconds([&] { run_legacy(log); }, repeat);
+  const double t_stream = seconds([&] { run_streaming(log); }, repeat);
+  const double total = (double)lines * repeat;
+  std::printf("%zu lines, %zu commits, %d passes\n", lines, legacy.size(), repeat);
+  std::printf("  regex      : %12.0f lines/sec\n", total / t_legacy);
+  std::printf("  streaming  : %12.0f lines/sec  (%.1fx)\n", total / t_stream, t_legacy / t_stream);
+  return 0;
+}
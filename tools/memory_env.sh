@@ -0,0 +1,24 @@
+#!/usr/bin/env bash
+# ==========================================================
+# memory_env.sh — Export the memory map for harness runs outside run.sh
+# Usage (from another tools/ script):
+#   source "$ROOT/tools/memory_env.sh"
+# Reads tools/memory_config.mk, the same file the RTL parameters and
+# run.sh come from, and exports PROGADDR_RESET, RAM_BASE, RAM_SIZE,
+# STACKADDR and TOHOST_ADDR under the names the harness reads. Variables
+# that are already set are kept.
+# ==========================================================
+
+_MEMORY_CONFIG="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)/memory_config.mk"
+# First hex value assigned to $1 in memory_config.mk
+_memory_config_value() {
+  sed -n "s/^$1[[:space:]]*:=[[:space:]]*\(0x[0-9A-Fa-f]*\).*/\1/p" "$_MEMORY_CONFIG" | head -n 1
+}
+
+export PROGADDR_RESET="${PROGADDR_RESET:-$(_memory_config_value PROGADDR_RESET)}"
+export RAM_BASE="${RAM_BASE:-$(_memory_config_value RAM_BASE)}"
+export RAM_SIZE="${RAM_SIZE:-$(_memory_config_value RAM_SIZE_ALIGNED)}"
+export STACKADDR="${STACKADDR:-${STACK_ADDR:-$(_memory_config_value STACK_ADDR)}}"
+export TOHOST_ADDR="${TOHOST_ADDR:-$(_memory_config_value TOHOST_ADDR)}"
+unset -f _memory_config_value
+unset _MEMORY_CONFIG
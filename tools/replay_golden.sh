@@ -7,6 +7,8 @@
 #   SPIKE_BIN, SPIKE_ISA=rv32imc, PK_BIN, OBJCOPY_BIN
 #   GOLDEN_MODE=live|off (live by default)
 #   XLEN=32 (passed through to harness)
+#   PROGADDR_RESET, RAM_BASE, RAM_SIZE, STACKADDR, TOHOST_ADDR
+#     (default: tools/memory_config.mk, as run.sh uses)
 # Output goes under workdir/replay-<timestamp>/
 # ==========================================================
 set -euo pipefail
@@ -31,6 +33,8 @@ export EXEC_BACKEND="${EXEC_BACKEND:-verilator}"
 export TRACE_MODE="${TRACE_MODE:-on}"
 export CRASH_LOG_DIR="$CRASH_DIR"
 export TRACE_DIR="$TRACES_DIR"
+# Memory map the RTL was built with
+source "$ROOT/tools/memory_env.sh"
 # Pass optional paths if provided
 [[ -n "${SPIKE_BIN:-}" ]] && export SPIKE_BIN
 [[ -n "${SPIKE_ISA:-}" ]] && export SPIKE_ISA
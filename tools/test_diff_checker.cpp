@@ -0,0 +1,110 @@
+#include "DifferentialChecker.hpp"
+#include "test_util.hpp"
+#include "HarnessConfig.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static std::string read_file(const std::string& path) {
+    std::ifstream in(path);
+    std::ostringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+enum class Fault { Reg, Minstret };
+
+// addi x(1 + i % 8), x0, i; the DUT gets @p fault wrong at commit @p bad
+static std::vector<CommitRec> commits(size_t n, size_t bad, Fault fault, bool dut) {
+    std::vector<CommitRec> recs;
+    for (size_t i = 0; i < n; ++i) {
+        CommitRec r;
+        r.pc_r = 0x80000000 + 4 * (uint32_t)i;
+        r.pc_w = r.pc_r + 4;
+        r.rd_addr = 1 + i % 8;
+        r.rd_wdata = (uint32_t)i;
+        r.insn = (r.rd_wdata << 20) | (r.rd_addr << 7) | 0x13;
+        if (i % 5 == 3) {  // sw x1, 0(x0) every few commits
+            r.rd_addr = r.rd_wdata = 0;
+            r.insn = 0x00102023;
+            r.mem_addr = 0x80040000;
+            r.mem_wdata = (uint32_t)i;
+            r.mem_is_store = 1;
+            if (dut) r.mem_wmask = 0xF;
+        }
+        if (dut) {  // RVFI counters; the golden side counts one per commit
+            r.csr_mcycle_wmask = r.csr_minstret_wmask = ~0ull;
+            r.csr_mcycle_wdata = r.csr_minstret_wdata = i + 1;
+        }
+        if (dut && i == bad && fault == Fault::Reg) r.rd_wdata ^= 0x100;
+        if (dut && i == bad && fault == Fault::Minstret) r.csr_minstret_wdata = i;
+        recs.push_back(r);
+    }
+    return recs;
+}
+
+// Feed both streams the way run_one_input() does; returns the crash log
+static std::string run(unsigned checkpoint, size_t n, size_t bad, Fault fault,
+                       const std::string& dir, const std::string& tag) {
+    HarnessConfig cfg;
+    cfg.crash_dir = dir;
+    cfg.objdump = "/nonexistent/objdump";
+    CrashLogger logger(cfg, tag);
+    DifferentialChecker checker;
+    checker.set_checkpoint(checkpoint);
+
+    const std::vector<unsigned char> input = {0x13, 0x00, 0x00, 0x00};
+    const std::vector<CommitRec> dut = commits(n, bad, fault, true);
+    const std::vector<CommitRec> gold = commits(n, bad, fault, false);
+    bool diverged = false;
+    for (size_t i = 0; i < n && !diverged; ++i) {
+        checker.update_dut_state(dut[i]);
+        checker.update_dut_csrs(dut[i]);
+        checker.update_golden_state(gold[i]);
+        diverged = checker.check_divergence(dut[i], gold[i], logger, 100 + 3 * (unsigned)i, input);
+    }
+    if (!diverged) diverged = checker.flush(logger, input);
+    if (!diverged) return "";
+    return read_file(logger.lastCrashBase() + ".log");
+}
+
+void test_same_report(const char* name, size_t n, size_t bad, Fault fault,
+                      const std::string& dir) {
+    std::cout << "\n" << name << std::endl;
+    const std::string detailed = run(0, n, bad, fault, dir, "detailed");
+    const std::string digest = run(8, n, bad, fault, dir, "digest");
+    const std::string cycle = "Cycle: " + std::to_string(100 + 3 * bad) + "\n";
+    check(detailed.find("Reason: golden_divergence_") == 0, "detailed mode reports a divergence");
+    check(detailed.find(cycle) != std::string::npos, "detailed mode reports the diverging commit");
+    check(!digest.empty() && digest == detailed, "digest mode writes the same report");
+}
+
+void test_no_divergence(const std::string& dir) {
+    std::cout << "\nNo divergence" << std::endl;
+    check(run(0, 40, ~size_t(0), Fault::Reg, dir, "detailed").empty(), "detailed mode stays quiet");
+    check(run(8, 40, ~size_t(0), Fault::Reg, dir, "digest").empty(), "digest mode stays quiet");
+}
+
+int main() {
+    std::cout << "Differential Checker Digest Mode Test" << std::endl;
+
+    char tmpl[] = "/tmp/test_diff_checker_XXXXXX";
+    const char* dir = ::mkdtemp(tmpl);
+    if (!dir) {
+        std::cerr << "mkdtemp failed" << std::endl;
+        return 1;
+    }
+
+    test_same_report("Divergence inside a full window", 40, 12, Fault::Reg, dir);
+    test_same_report("Divergence in the window left at flush()", 38, 35, Fault::Reg, dir);
+    test_same_report("Divergence in the first commit", 40, 0, Fault::Reg, dir);
+    test_same_report("CSR counter divergence", 40, 21, Fault::Minstret, dir);
+    test_no_divergence(dir);
+
+    std::system(("rm -rf '" + std::string(dir) + "'").c_str());
+
+    return test_summary();
+}
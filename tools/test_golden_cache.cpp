@@ -0,0 +1,158 @@
+#include "GoldenCache.hpp"
+#include "test_util.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+static bool same_rec(const CommitRec& a, const CommitRec& b) {
+    return a.pc_r == b.pc_r && a.pc_w == b.pc_w && a.insn == b.insn &&
+           a.rd_addr == b.rd_addr && a.rd_wdata == b.rd_wdata &&
+           a.mem_addr == b.mem_addr && a.mem_rmask == b.mem_rmask &&
+           a.mem_wmask == b.mem_wmask && a.trap == b.trap &&
+           a.mem_wdata == b.mem_wdata && a.mem_rdata == b.mem_rdata &&
+           a.mem_is_load == b.mem_is_load && a.mem_is_store == b.mem_is_store &&
+           a.csr_mcycle_wmask == b.csr_mcycle_wmask &&
+           a.csr_mcycle_wdata == b.csr_mcycle_wdata &&
+           a.csr_minstret_wmask == b.csr_minstret_wmask &&
+           a.csr_minstret_wdata == b.csr_minstret_wdata;
+}
+
+// One record per encoder flag, plus one with every field set
+static std::vector<CommitRec> sample_commits() {
+    std::vector<CommitRec> recs;
+    CommitRec r;
+
+    r.pc_r = 0x80000000; r.pc_w = 0x80000004; r.insn = 0x00100093;  // addi x1, x0, 1
+    r.rd_addr = 1; r.rd_wdata = 1;
+    recs.push_back(r);
+
+    r = CommitRec();                                                // jal x0, -4
+    r.pc_r = 0x80000004; r.pc_w = 0x80000000; r.insn = 0xffdff06f;
+    recs.push_back(r);
+
+    r = CommitRec();                                                // pc_r not the previous pc_w
+    r.pc_r = 0x80000100; r.pc_w = 0x80000102; r.insn = 0x00000001;  // c.nop
+    recs.push_back(r);
+
+    r = CommitRec();                                                // sw x1, 8(x0)
+    r.pc_r = 0x80000102; r.pc_w = 0x80000106; r.insn = 0x00102423;
+    r.mem_addr = 0x80040008; r.mem_wmask = 0xF; r.mem_wdata = 0xdeadbeef; r.mem_is_store = 1;
+    recs.push_back(r);
+
+    r = CommitRec();                                                // lb x2, 9(x0)
+    r.pc_r = 0x80000106; r.pc_w = 0x8000010a; r.insn = 0x00900103;
+    r.rd_addr = 2; r.rd_wdata = 0xffffffbe;
+    r.mem_addr = 0x80040008; r.mem_rmask = 0x2; r.mem_rdata = 0xdeadbeef; r.mem_is_load = 1;
+    recs.push_back(r);
+
+    r = CommitRec();                                                // ecall
+    r.pc_r = 0x8000010a; r.pc_w = 0x00000010; r.insn = 0x00000073; r.trap = 1;
+    recs.push_back(r);
+
+    r = CommitRec();                                                // csrw mcycle
+    r.pc_r = 0x00000010; r.pc_w = 0x00000014; r.insn = 0xb0009073;
+    r.csr_mcycle_wmask = ~0ull; r.csr_mcycle_wdata = 0x123456789abcdefull;
+    r.csr_minstret_wmask = 0xffffffffull; r.csr_minstret_wdata = 42;
+    recs.push_back(r);
+
+    r.pc_r = 0x11111111; r.pc_w = 0x22222222; r.insn = 0x33333333;  // Everything at once
+    r.rd_addr = 31; r.rd_wdata = 0x44444444;
+    r.mem_addr = 0x55555555; r.mem_rmask = 0x6; r.mem_wmask = 0x9; r.trap = 7;
+    r.mem_wdata = 0x77777777; r.mem_rdata = 0x88888888; r.mem_is_load = 1; r.mem_is_store = 1;
+    r.csr_mcycle_wmask = 0xaaaaaaaaaaaaaaaaull; r.csr_mcycle_wdata = 0xbbbbbbbbbbbbbbbbull;
+    r.csr_minstret_wmask = 0xccccccccccccccccull; r.csr_minstret_wdata = 0xddddddddddddddddull;
+    recs.push_back(r);
+    return recs;
+}
+
+void test_round_trip() {
+    std::cout << "\nCommitEncoder/CommitDecoder round trip" << std::endl;
+    const std::vector<CommitRec> recs = sample_commits();
+
+    // pc_r is predicted from the previous pc_w, which starts at 0
+    CommitEncoder enc;
+    std::vector<uint8_t> alu;
+    CommitRec straight = recs[0];
+    straight.pc_r = 0;
+    straight.pc_w = 4;
+    enc.append(straight, alu);
+    check(alu.size() == 13, "straight-line ALU commit encodes to 13 bytes");
+
+    enc.reset();
+    std::vector<uint8_t> stream;
+    for (const CommitRec& r : recs) enc.append(r, stream);
+
+    CommitDecoder dec;
+    dec.reset(stream.data(), stream.size());
+    size_t n = 0;
+    bool all_same = true;
+    CommitRec out;
+    while (dec.next(out)) {
+        if (n >= recs.size() || !same_rec(out, recs[n])) {
+            std::cerr << "    mismatch at record " << n << std::endl;
+            all_same = false;
+        }
+        n++;
+    }
+    check(n == recs.size(), "decoder returns every record");
+    check(all_same, "every CommitRec field survives the round trip");
+
+    dec.reset(stream.data(), stream.size() - 1);
+    n = 0;
+    while (dec.next(out)) n++;
+    check(n == recs.size() - 1, "truncated stream stops before the torn record");
+}
+
+void test_eviction() {
+    std::cout << "\nGoldenCache eviction on log wrap" << std::endl;
+    char path[] = "/tmp/test_golden_cache_XXXXXX";
+    int fd = ::mkstemp(path);
+    if (fd < 0) {
+        check(false, "create cache file");
+        return;
+    }
+    ::close(fd);
+
+    GoldenCache cache;
+    check(cache.open(path, 1u << 20), "open a 1 MiB cache");
+
+    // Slot 1000 is not shared with keys 1..N, so only the log wrap can evict it
+    const uint64_t old_key = 1000;
+    GoldenCache::Entry entry;
+    entry.payload.assign(64 * 1024, 0x5a);
+    entry.commits = 123;
+    entry.flags = 1;
+    check(cache.insert(old_key, ~old_key, entry), "insert the first entry");
+
+    GoldenCache::Entry got;
+    check(cache.lookup(old_key, ~old_key, got) && got.payload == entry.payload &&
+          got.commits == 123 && got.flags == 1, "first entry hits before the wrap");
+    check(!cache.lookup(old_key, old_key, got), "wrong check hash misses");
+
+    uint64_t key = 1;
+    for (; key <= 32; ++key) {
+        entry.payload.assign(64 * 1024, (uint8_t)key);
+        cache.insert(key, ~key, entry);
+    }
+    check(!cache.lookup(old_key, ~old_key, got), "first entry is evicted once the log wraps");
+    check(cache.lookup(key - 1, ~(key - 1), got) && got.payload[0] == (uint8_t)(key - 1),
+          "newest entry still hits");
+
+    entry.payload.assign(1u << 20, 0);
+    check(!cache.insert(4242, 0, entry), "entry larger than 1/8 of the log is refused");
+
+    cache.close();
+    ::unlink(path);
+}
+
+int main() {
+    std::cout << "Golden Cache Test" << std::endl;
+
+    test_round_trip();
+    test_eviction();
+
+    return test_summary();
+}
@@ -0,0 +1,72 @@
+#include "MemDigest.hpp"
+#include "test_util.hpp"
+#include <iostream>
+#include <string>
+
+void test_order() {
+    std::cout << "\nMemDigest order independence" << std::endl;
+    MemDigest a, b;
+    check(a.value() == 0, "empty digest is 0");
+
+    // a: word store, then overwrite one byte; b: the same bytes lane by lane, reversed
+    a.store(0x80040000, 0x11223344, 0xF);
+    a.store(0x80040000, 0x0000aa00, 0x2);
+    a.store(0x80040010, 0x00000055, 0x1);
+    b.store(0x80040010, 0xffffff55, 0x1);
+    b.store(0x80040000, 0x11000000, 0x8);
+    b.store(0x80040000, 0x00220000, 0x4);
+    b.store(0x80040000, 0x0000aa00, 0x2);
+    b.store(0x80040002, 0x00000044, 0x1);  // Unaligned address: same word
+    b.store(0x80040000, 0x00000044, 0x1);
+    check(a.value() == b.value(), "same final bytes give the same digest");
+    check(a.words() == 2 && b.words() == 2, "two distinct words tracked");
+
+    const MemDigest::Word* w = b.lookup(0x80040003);
+    check(w && w->data == 0x1122aa44 && w->mask == 0xF, "lookup returns the merged word");
+
+    b.store(0x80040010, 0x00000000, 0x2);  // Writing a zero still counts as a write
+    check(a.value() != b.value(), "an extra written lane changes the digest");
+    check(b.value_without(0x80040100) == b.value(), "value_without of an unwritten word is value()");
+    check(a.value_without(0x80040010) == b.value_without(0x80040010),
+          "value_without matches once the differing word is left out");
+
+    a.store(0x80040020, 0x12345678, 0x0);
+    check(a.words() == 2, "store with an empty wstrb is ignored");
+
+    a.reset();
+    check(a.value() == 0 && a.words() == 0 && !a.lookup(0x80040000), "reset forgets every write");
+}
+
+void test_grow() {
+    std::cout << "\nMemDigest after grow()" << std::endl;
+    MemDigest a, b;
+    // 4096 words: grows the 1024-slot table several times, in different orders
+    const uint32_t n = 4096;
+    for (uint32_t i = 0; i < n; ++i) a.store(0x80040000 + 4 * i, i * 0x9e3779b9u, 0xF);
+    for (uint32_t i = n; i-- > 0;) b.store(0x80040000 + 4 * i, i * 0x9e3779b9u, 0xF);
+    check(a.words() == n && b.words() == n, "every word kept across grow()");
+    check(a.value() == b.value(), "digest unchanged by growing in a different order");
+
+    bool found = true;
+    for (uint32_t i = 0; i < n; ++i) {
+        const MemDigest::Word* w = a.lookup(0x80040000 + 4 * i);
+        found = found && w && w->data == i * 0x9e3779b9u;
+    }
+    check(found, "every word still found after grow()");
+
+    // Runs after a grow() reuse the large table
+    a.reset();
+    b.reset();
+    a.store(0x80040000, 1, 0xF);
+    b.store(0x80040000, 1, 0xF);
+    check(a.words() == 1 && a.value() == b.value(), "reset after grow() starts clean");
+}
+
+int main() {
+    std::cout << "Memory Digest Test" << std::endl;
+
+    test_order();
+    test_grow();
+
+    return test_summary();
+}
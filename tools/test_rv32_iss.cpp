@@ -0,0 +1,162 @@
+#include "Rv32Iss.hpp"
+#include "test_util.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const uint32_t kBase = 0x80000000;
+static const uint32_t kData = 0x80040000;
+
+// ============================================================================
+// Encoders
+// ============================================================================
+
+static uint32_t r_type(uint32_t f7, uint32_t rs2, uint32_t rs1, uint32_t f3, uint32_t rd) {
+    return (f7 << 25) | (rs2 << 20) | (rs1 << 15) | (f3 << 12) | (rd << 7) | 0x33;
+}
+
+static uint32_t i_type(int32_t imm, uint32_t rs1, uint32_t f3, uint32_t rd, uint32_t op) {
+    return ((uint32_t)imm << 20) | (rs1 << 15) | (f3 << 12) | (rd << 7) | op;
+}
+
+static uint32_t s_type(int32_t imm, uint32_t rs2, uint32_t rs1, uint32_t f3) {
+    const uint32_t u = (uint32_t)imm;
+    return (((u >> 5) & 0x7F) << 25) | (rs2 << 20) | (rs1 << 15) | (f3 << 12) |
+           ((u & 0x1F) << 7) | 0x23;
+}
+
+// lui + addi, with the carry the sign-extended addi immediate needs
+static void li(std::vector<uint32_t>& prog, uint32_t rd, uint32_t value) {
+    const uint32_t lo = value & 0xFFF;
+    const uint32_t hi = (value + (lo & 0x800 ? 0x1000 : 0)) & 0xFFFFF000u;
+    prog.push_back(hi | (rd << 7) | 0x37);
+    prog.push_back(i_type((int32_t)(lo << 20) >> 20, rd, 0, rd, 0x13));
+}
+
+// Run @p prog at kBase until its last instruction or a halt; returns every commit
+static std::vector<CommitRec> run(Rv32Iss& iss, const std::vector<uint32_t>& prog) {
+    iss.reset(kBase, 0xFFFFFFFFu);
+    iss.load(kBase, reinterpret_cast<const unsigned char*>(prog.data()), 4 * prog.size());
+    std::vector<CommitRec> recs;
+    CommitRec rec;
+    for (size_t i = 0; i < prog.size() && iss.step(rec); ++i) recs.push_back(rec);
+    return recs;
+}
+
+// x3 = x1 <op> x2 for an OP-format instruction
+static uint32_t alu(uint32_t f7, uint32_t f3, uint32_t a, uint32_t b) {
+    Rv32Iss iss;
+    std::vector<uint32_t> prog;
+    li(prog, 1, a);
+    li(prog, 2, b);
+    prog.push_back(r_type(f7, 2, 1, f3, 3));
+    const std::vector<CommitRec> recs = run(iss, prog);
+    return recs.size() == prog.size() ? recs.back().rd_wdata : 0xDEADDEADu;
+}
+
+// Last commit of li x1, kData; li x2, 0x8081FF7F; sw x2, 0(x1); @p insn
+static CommitRec after_store(Rv32Iss& iss, uint32_t insn) {
+    std::vector<uint32_t> prog;
+    li(prog, 1, kData);
+    li(prog, 2, 0x8081FF7F);
+    prog.push_back(s_type(0, 2, 1, 2));
+    prog.push_back(insn);
+    const std::vector<CommitRec> recs = run(iss, prog);
+    return recs.empty() ? CommitRec() : recs.back();
+}
+
+// Single instruction at kBase: true if it retired as a trap and halted the model
+static bool traps(uint32_t insn, bool* clean = nullptr) {
+    Rv32Iss iss;
+    const std::vector<CommitRec> recs = run(iss, {insn});
+    if (clean) *clean = iss.exited();
+    return recs.size() == 1 && recs[0].trap && recs[0].rd_addr == 0 &&
+           recs[0].pc_w == kBase && iss.halted();
+}
+
+// ============================================================================
+// Checks
+// ============================================================================
+
+void test_div_rem() {
+    std::cout << "\nDivision corner cases" << std::endl;
+    check(alu(0x01, 4, 7, 0) == 0xFFFFFFFFu, "div by zero is -1");
+    check(alu(0x01, 5, 7, 0) == 0xFFFFFFFFu, "divu by zero is 2^32-1");
+    check(alu(0x01, 6, 7, 0) == 7, "rem by zero is the dividend");
+    check(alu(0x01, 7, 0xFFFFFFF9u, 0) == 0xFFFFFFF9u, "remu by zero is the dividend");
+    check(alu(0x01, 4, 0x80000000u, 0xFFFFFFFFu) == 0x80000000u, "div overflow is the dividend");
+    check(alu(0x01, 6, 0x80000000u, 0xFFFFFFFFu) == 0, "rem overflow is 0");
+    check(alu(0x01, 4, (uint32_t)-7, 2) == (uint32_t)-3, "div rounds towards zero");
+    check(alu(0x01, 6, (uint32_t)-7, 2) == (uint32_t)-1, "rem takes the dividend's sign");
+    check(alu(0x01, 5, 0xFFFFFFF9u, 2) == 0x7FFFFFFCu, "divu is unsigned");
+}
+
+void test_mul() {
+    std::cout << "\nMultiplication" << std::endl;
+    check(alu(0x01, 0, 0x12345678u, 0x9ABCDEF0u) == 0x242D2080u, "mul keeps the low word");
+    check(alu(0x01, 1, 0x12345678u, 0x9ABCDEF0u) == 0xF8CC93D6u, "mulh is signed x signed");
+    check(alu(0x01, 3, 0x12345678u, 0x9ABCDEF0u) == 0x0B00EA4Eu, "mulhu is unsigned x unsigned");
+    check(alu(0x01, 1, 0x80000000u, 0x80000000u) == 0x40000000u, "mulh of two INT_MIN");
+    check(alu(0x01, 3, 0xFFFFFFFFu, 0xFFFFFFFFu) == 0xFFFFFFFEu, "mulhu of two UINT_MAX");
+    check(alu(0x01, 2, 0xFFFFFFFFu, 0xFFFFFFFFu) == 0xFFFFFFFFu, "mulhsu of -1 and UINT_MAX");
+    check(alu(0x01, 2, 0x80000000u, 0xFFFFFFFFu) == 0x80000000u, "mulhsu of INT_MIN and UINT_MAX");
+}
+
+void test_shifts() {
+    std::cout << "\nShift amounts of 32 and above" << std::endl;
+    check(alu(0x00, 1, 0x00000001u, 33) == 0x00000002u, "sll uses the low 5 bits of rs2");
+    check(alu(0x00, 5, 0x80000000u, 32) == 0x80000000u, "srl by 32 shifts by 0");
+    check(alu(0x20, 5, 0x80000000u, 0x3F) == 0xFFFFFFFFu, "sra by 63 shifts by 31");
+    check(traps(i_type(0x020 | 1, 0, 1, 1, 0x13)), "slli with shamt[5] set is illegal");
+    check(traps(i_type(0x020 | 1, 0, 5, 1, 0x13)), "srli with shamt[5] set is illegal");
+}
+
+void test_loads() {
+    std::cout << "\nLoad sign extension (word 0x8081FF7F)" << std::endl;
+    Rv32Iss iss;
+    check(after_store(iss, i_type(0, 1, 0, 3, 0x03)).rd_wdata == 0x0000007Fu, "lb of 0x7F");
+    check(after_store(iss, i_type(1, 1, 0, 3, 0x03)).rd_wdata == 0xFFFFFFFFu, "lb of 0xFF");
+    check(after_store(iss, i_type(1, 1, 4, 3, 0x03)).rd_wdata == 0x000000FFu, "lbu of 0xFF");
+    check(after_store(iss, i_type(2, 1, 1, 3, 0x03)).rd_wdata == 0xFFFF8081u, "lh of 0x8081");
+    check(after_store(iss, i_type(2, 1, 5, 3, 0x03)).rd_wdata == 0x00008081u, "lhu of 0x8081");
+    check(after_store(iss, i_type(0, 1, 1, 3, 0x03)).rd_wdata == 0xFFFFFF7Fu, "lh of 0xFF7F");
+
+    const CommitRec lb3 = after_store(iss, i_type(3, 1, 0, 3, 0x03));
+    check(lb3.rd_wdata == 0xFFFFFF80u, "lb of the top byte");
+    check(lb3.mem_addr == kData && lb3.mem_rmask == 0x8 && lb3.mem_rdata == 0x8081FF7Fu &&
+          lb3.mem_is_load, "lb reports the RVFI word, lane mask and read data");
+}
+
+void test_traps() {
+    std::cout << "\nTraps" << std::endl;
+    Rv32Iss iss;
+    CommitRec rec = after_store(iss, i_type(2, 1, 2, 3, 0x03));  // lw x3, 2(x1)
+    check(rec.trap && iss.halted() && !iss.exited() && rec.rd_addr == 0, "misaligned lw traps");
+    rec = after_store(iss, s_type(1, 2, 1, 1));                   // sh x2, 1(x1)
+    check(rec.trap && rec.mem_wmask == 0 && !rec.mem_is_store, "misaligned sh traps without writing");
+    rec = after_store(iss, i_type(2, 0, 0, 1, 0x67));             // jalr x1, 2(x0)
+    check(rec.trap && rec.rd_addr == 0, "misaligned jalr target traps without linking");
+    check(traps((3u << 8) | 0x63), "misaligned branch target traps");  // beq x0, x0, 6
+    check(!traps((3u << 8) | (1u << 12) | 0x63), "untaken misaligned branch retires");  // bne x0, x0, 6
+
+    bool clean = false;
+    check(traps(0x00000000u), "all-zero word is illegal");
+    check(traps(0x00000001u), "compressed encodings are illegal");
+    check(traps(r_type(0x02, 2, 1, 0, 3)), "unknown OP funct7 is illegal");
+    check(traps(i_type(0x300, 0, 2, 1, 0x73)), "csrr of mstatus is illegal");
+    check(traps(i_type(0xC00, 1, 2, 1, 0x73)), "rdcycle with rs1 != x0 is illegal");
+    check(traps(0x00000073u, &clean) && clean, "ecall traps and exits cleanly");
+    check(traps(0x00100073u, &clean) && !clean, "ebreak traps as a fault");
+}
+
+int main() {
+    std::cout << "RV32IM ISS Test" << std::endl;
+
+    test_div_rem();
+    test_mul();
+    test_shifts();
+    test_loads();
+    test_traps();
+
+    return test_summary();
+}
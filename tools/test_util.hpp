@@ -0,0 +1,34 @@
+/**
+ * @file test_util.hpp
+ * @brief Pass/fail helpers shared by the tools/test_*.cpp unit checks
+ *
+ * Example usage:
+ * @code
+ *   int main() {
+ *     check(1 + 1 == 2, "addition works");
+ *     return test_summary();
+ *   }
+ * @endcode
+ */
+
+#pragma once
+
+#include <iostream>
+#include <string>
+
+inline int& test_failures() {
+    static int failures = 0;
+    return failures;
+}
+
+/// @brief Print one result line and count a failure
+inline void check(bool ok, const std::string& what) {
+    std::cout << (ok ? "  ✓ " : "  ✗ ") << what << std::endl;
+    if (!ok) test_failures()++;
+}
+
+/// @brief Print PASSED/FAILED; the result is the process exit code
+inline int test_summary() {
+    std::cout << "\n" << (test_failures() ? "FAILED" : "PASSED") << std::endl;
+    return test_failures() ? 1 : 0;
+}
@@ -0,0 +1,60 @@
+// ==========================================================
+// trace_convert.cpp — Convert recorded commit streams between formats
+// Build:  make -C afl trace-convert
+// Usage:  afl/trace_convert [--csv] <in> <out>
+// <in> is a binary trace, a CSV golden.trace/dut.trace or a raw `spike -l`
+// log (detected from its contents). <out> is written as a binary trace for
+// GOLDEN_MODE=replay, or as CSV with --csv (e.g. to read a binary
+// dut.trace/golden.trace from TRACE_MODE=on).
+// ==========================================================
+
+#include "TraceFile.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+int main(int argc, char** argv) {
+  bool csv = false;
+  const char* in = nullptr;
+  const char* out = nullptr;
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--csv") == 0) {
+      csv = true;
+    } else if (!in) {
+      in = argv[i];
+    } else if (!out) {
+      out = argv[i];
+    }
+  }
+  if (!in || !out) {
+    std::fprintf(stderr, "Usage: %s [--csv] <in> <out>\n", argv[0]);
+    return 2;
+  }
+
+  TraceFile trace;
+  if (!trace.load(in)) {
+    std::fprintf(stderr, "%s\n", trace.error().c_str());
+    return 1;
+  }
+  static const char* const kFormats[] = {"binary", "csv", "spike log"};
+  std::printf("%s: %s, %zu commits%s\n", in, kFormats[(int)trace.format()],
+              trace.commits().size(), trace.finished() ? ", finished" : "");
+
+  if (csv) {
+    const std::string path = out;
+    const size_t slash = path.rfind('/');
+    TraceWriter writer;
+    writer.set_format(TraceWriter::Format::Csv);
+    if (!writer.open_with_basename(slash == std::string::npos ? "." : path.substr(0, slash),
+                                   slash == std::string::npos ? path : path.substr(slash + 1))) {
+      std::fprintf(stderr, "cannot write %s\n", out);
+      return 1;
+    }
+    for (const CommitRec& rec : trace.commits()) writer.write(rec);
+  } else if (!TraceFile::save(out, trace.commits(), trace.finished())) {
+    std::fprintf(stderr, "cannot write %s\n", out);
+    return 1;
+  }
+  return 0;
+}